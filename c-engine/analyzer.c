@@ -0,0 +1,366 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "analyzer.h"
+
+// English stop words, kept sorted for bsearch
+static const char* STOP_WORDS[] = {
+    "about", "above", "after", "again", "against", "all", "also", "am", "an", "and",
+    "any", "are", "as", "at", "be", "because", "been", "before", "being", "below",
+    "between", "both", "but", "by", "can", "could", "did", "do", "does", "doing",
+    "down", "during", "each", "few", "for", "from", "further", "had", "has", "have",
+    "having", "he", "her", "here", "hers", "herself", "him", "himself", "his", "how",
+    "if", "in", "into", "is", "it", "its", "itself", "just", "may", "me",
+    "might", "more", "most", "must", "my", "myself", "no", "nor", "not", "now",
+    "of", "off", "on", "once", "only", "or", "other", "our", "ours", "ourselves",
+    "out", "over", "own", "same", "shall", "she", "should", "so", "some", "such",
+    "than", "that", "the", "their", "theirs", "them", "themselves", "then", "there", "these",
+    "they", "this", "those", "through", "to", "too", "under", "until", "up", "upon",
+    "us", "very", "was", "we", "were", "what", "when", "where", "which", "while",
+    "who", "whom", "why", "will", "with", "would", "you", "your", "yours", "yourself",
+    "yourselves"
+};
+
+#define STOP_WORD_COUNT (int)(sizeof(STOP_WORDS) / sizeof(STOP_WORDS[0]))
+
+void initAnalyzer(Analyzer* analyzer) {
+    analyzer->removeStopWords = 1;
+    analyzer->stem = 1;
+    analyzer->minLength = 2;
+    analyzer->maxLength = MAX_WORD_LENGTH - 1;
+}
+
+// Spec is a comma separated list such as "stop,stem,min=3,max=30" or "none".
+// Returns 0 if the spec contains an unknown option.
+int parseAnalyzerSpec(Analyzer* analyzer, const char* spec) {
+    char buffer[MAX_ANALYZER_SPEC];
+    strncpy(buffer, spec, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    analyzer->removeStopWords = 0;
+    analyzer->stem = 0;
+    analyzer->minLength = 2;
+    analyzer->maxLength = MAX_WORD_LENGTH - 1;
+
+    char* option = strtok(buffer, ",");
+    while (option != NULL) {
+        if (strcmp(option, "stop") == 0) {
+            analyzer->removeStopWords = 1;
+        } else if (strcmp(option, "stem") == 0) {
+            analyzer->stem = 1;
+        } else if (strncmp(option, "min=", 4) == 0) {
+            analyzer->minLength = atoi(option + 4);
+        } else if (strncmp(option, "max=", 4) == 0) {
+            analyzer->maxLength = atoi(option + 4);
+        } else if (strcmp(option, "none") != 0) {
+            return 0;
+        }
+        option = strtok(NULL, ",");
+    }
+
+    if (analyzer->minLength < 1) analyzer->minLength = 1;
+    if (analyzer->maxLength > MAX_WORD_LENGTH - 1) analyzer->maxLength = MAX_WORD_LENGTH - 1;
+    if (analyzer->maxLength < analyzer->minLength) analyzer->maxLength = analyzer->minLength;
+    return 1;
+}
+
+void describeAnalyzer(const Analyzer* analyzer, char* buffer, int size) {
+    snprintf(buffer, size, "%s%smin=%d,max=%d",
+             analyzer->removeStopWords ? "stop," : "",
+             analyzer->stem ? "stem," : "",
+             analyzer->minLength, analyzer->maxLength);
+}
+
+static int compareStopWord(const void* key, const void* element) {
+    return strcmp((const char*)key, *(const char* const*)element);
+}
+
+int isStopWord(const char* word) {
+    return bsearch(word, STOP_WORDS, STOP_WORD_COUNT, sizeof(STOP_WORDS[0]), compareStopWord) != NULL;
+}
+
+// Runs the full chain on one raw token. Writes the resulting term and
+// returns 1, or returns 0 if the token is filtered out.
+int analyzeToken(const Analyzer* analyzer, const char* token, char* term) {
+    int length = 0;
+    for (int i = 0; token[i] != '\0'; i++) {
+        if (!isalpha((unsigned char)token[i])) continue;
+        if (length >= analyzer->maxLength) return 0;
+        term[length++] = tolower((unsigned char)token[i]);
+    }
+    term[length] = '\0';
+
+    if (length < analyzer->minLength) return 0;
+    if (analyzer->removeStopWords && isStopWord(term)) return 0;
+
+    if (analyzer->stem) {
+        stemWord(term);
+    }
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Porter stemmer (M.F. Porter, "An algorithm for suffix stripping", 1980).
+// Operates in place on a lowercase word; b[0..k] is the live part of the word.
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    char* b;
+    int k;
+    int j;
+} Stemmer;
+
+static int isConsonant(Stemmer* z, int i) {
+    switch (z->b[i]) {
+        case 'a': case 'e': case 'i': case 'o': case 'u':
+            return 0;
+        case 'y':
+            return i == 0 ? 1 : !isConsonant(z, i - 1);
+        default:
+            return 1;
+    }
+}
+
+// Number of consonant-vowel sequences in b[0..j]
+static int measure(Stemmer* z) {
+    int n = 0;
+    int i = 0;
+    while (1) {
+        if (i > z->j) return n;
+        if (!isConsonant(z, i)) break;
+        i++;
+    }
+    i++;
+    while (1) {
+        while (1) {
+            if (i > z->j) return n;
+            if (isConsonant(z, i)) break;
+            i++;
+        }
+        i++;
+        n++;
+        while (1) {
+            if (i > z->j) return n;
+            if (!isConsonant(z, i)) break;
+            i++;
+        }
+        i++;
+    }
+}
+
+static int vowelInStem(Stemmer* z) {
+    for (int i = 0; i <= z->j; i++) {
+        if (!isConsonant(z, i)) return 1;
+    }
+    return 0;
+}
+
+static int doubleConsonant(Stemmer* z, int j) {
+    if (j < 1) return 0;
+    if (z->b[j] != z->b[j - 1]) return 0;
+    return isConsonant(z, j);
+}
+
+// True if b[i-2..i] is consonant-vowel-consonant and the last is not w, x or y
+static int cvc(Stemmer* z, int i) {
+    if (i < 2 || !isConsonant(z, i) || isConsonant(z, i - 1) || !isConsonant(z, i - 2)) return 0;
+    int ch = z->b[i];
+    return !(ch == 'w' || ch == 'x' || ch == 'y');
+}
+
+static int endsWith(Stemmer* z, const char* s) {
+    int length = strlen(s);
+    if (length > z->k + 1) return 0;
+    if (memcmp(z->b + z->k - length + 1, s, length) != 0) return 0;
+    z->j = z->k - length;
+    return 1;
+}
+
+static void setTo(Stemmer* z, const char* s) {
+    int length = strlen(s);
+    memcpy(z->b + z->j + 1, s, length);
+    z->k = z->j + length;
+}
+
+static void replaceIfMeasured(Stemmer* z, const char* s) {
+    if (measure(z) > 0) setTo(z, s);
+}
+
+// Plurals and -ed / -ing
+static void step1ab(Stemmer* z) {
+    if (z->b[z->k] == 's') {
+        if (endsWith(z, "sses")) z->k -= 2;
+        else if (endsWith(z, "ies")) setTo(z, "i");
+        else if (z->b[z->k - 1] != 's') z->k--;
+    }
+    if (endsWith(z, "eed")) {
+        if (measure(z) > 0) z->k--;
+    } else if ((endsWith(z, "ed") || endsWith(z, "ing")) && vowelInStem(z)) {
+        z->k = z->j;
+        if (endsWith(z, "at")) setTo(z, "ate");
+        else if (endsWith(z, "bl")) setTo(z, "ble");
+        else if (endsWith(z, "iz")) setTo(z, "ize");
+        else if (doubleConsonant(z, z->k)) {
+            z->k--;
+            int ch = z->b[z->k];
+            if (ch == 'l' || ch == 's' || ch == 'z') z->k++;
+        } else if (measure(z) == 1 && cvc(z, z->k)) {
+            z->j = z->k;
+            setTo(z, "e");
+        }
+    }
+}
+
+// Terminal y -> i when there is another vowel in the stem
+static void step1c(Stemmer* z) {
+    if (endsWith(z, "y") && vowelInStem(z)) z->b[z->k] = 'i';
+}
+
+// Double suffixes to single ones
+static void step2(Stemmer* z) {
+    if (z->k < 1) return;
+    switch (z->b[z->k - 1]) {
+        case 'a':
+            if (endsWith(z, "ational")) { replaceIfMeasured(z, "ate"); break; }
+            if (endsWith(z, "tional")) { replaceIfMeasured(z, "tion"); break; }
+            break;
+        case 'c':
+            if (endsWith(z, "enci")) { replaceIfMeasured(z, "ence"); break; }
+            if (endsWith(z, "anci")) { replaceIfMeasured(z, "ance"); break; }
+            break;
+        case 'e':
+            if (endsWith(z, "izer")) { replaceIfMeasured(z, "ize"); break; }
+            break;
+        case 'l':
+            if (endsWith(z, "bli")) { replaceIfMeasured(z, "ble"); break; }
+            if (endsWith(z, "alli")) { replaceIfMeasured(z, "al"); break; }
+            if (endsWith(z, "entli")) { replaceIfMeasured(z, "ent"); break; }
+            if (endsWith(z, "eli")) { replaceIfMeasured(z, "e"); break; }
+            if (endsWith(z, "ousli")) { replaceIfMeasured(z, "ous"); break; }
+            break;
+        case 'o':
+            if (endsWith(z, "ization")) { replaceIfMeasured(z, "ize"); break; }
+            if (endsWith(z, "ation")) { replaceIfMeasured(z, "ate"); break; }
+            if (endsWith(z, "ator")) { replaceIfMeasured(z, "ate"); break; }
+            break;
+        case 's':
+            if (endsWith(z, "alism")) { replaceIfMeasured(z, "al"); break; }
+            if (endsWith(z, "iveness")) { replaceIfMeasured(z, "ive"); break; }
+            if (endsWith(z, "fulness")) { replaceIfMeasured(z, "ful"); break; }
+            if (endsWith(z, "ousness")) { replaceIfMeasured(z, "ous"); break; }
+            break;
+        case 't':
+            if (endsWith(z, "aliti")) { replaceIfMeasured(z, "al"); break; }
+            if (endsWith(z, "iviti")) { replaceIfMeasured(z, "ive"); break; }
+            if (endsWith(z, "biliti")) { replaceIfMeasured(z, "ble"); break; }
+            break;
+        case 'g':
+            if (endsWith(z, "logi")) { replaceIfMeasured(z, "log"); break; }
+            break;
+    }
+}
+
+// -ic-, -full, -ness etc.
+static void step3(Stemmer* z) {
+    switch (z->b[z->k]) {
+        case 'e':
+            if (endsWith(z, "icate")) { replaceIfMeasured(z, "ic"); break; }
+            if (endsWith(z, "ative")) { replaceIfMeasured(z, ""); break; }
+            if (endsWith(z, "alize")) { replaceIfMeasured(z, "al"); break; }
+            break;
+        case 'i':
+            if (endsWith(z, "iciti")) { replaceIfMeasured(z, "ic"); break; }
+            break;
+        case 'l':
+            if (endsWith(z, "ical")) { replaceIfMeasured(z, "ic"); break; }
+            if (endsWith(z, "ful")) { replaceIfMeasured(z, ""); break; }
+            break;
+        case 's':
+            if (endsWith(z, "ness")) { replaceIfMeasured(z, ""); break; }
+            break;
+    }
+}
+
+// -ant, -ence etc. in context <c>vcvc<v>
+static void step4(Stemmer* z) {
+    if (z->k < 1) return;
+    switch (z->b[z->k - 1]) {
+        case 'a':
+            if (endsWith(z, "al")) break;
+            return;
+        case 'c':
+            if (endsWith(z, "ance")) break;
+            if (endsWith(z, "ence")) break;
+            return;
+        case 'e':
+            if (endsWith(z, "er")) break;
+            return;
+        case 'i':
+            if (endsWith(z, "ic")) break;
+            return;
+        case 'l':
+            if (endsWith(z, "able")) break;
+            if (endsWith(z, "ible")) break;
+            return;
+        case 'n':
+            if (endsWith(z, "ant")) break;
+            if (endsWith(z, "ement")) break;
+            if (endsWith(z, "ment")) break;
+            if (endsWith(z, "ent")) break;
+            return;
+        case 'o':
+            if (endsWith(z, "ion") && z->j >= 0 && (z->b[z->j] == 's' || z->b[z->j] == 't')) break;
+            if (endsWith(z, "ou")) break;
+            return;
+        case 's':
+            if (endsWith(z, "ism")) break;
+            return;
+        case 't':
+            if (endsWith(z, "ate")) break;
+            if (endsWith(z, "iti")) break;
+            return;
+        case 'u':
+            if (endsWith(z, "ous")) break;
+            return;
+        case 'v':
+            if (endsWith(z, "ive")) break;
+            return;
+        case 'z':
+            if (endsWith(z, "ize")) break;
+            return;
+        default:
+            return;
+    }
+    if (measure(z) > 1) z->k = z->j;
+}
+
+// Final -e and -ll
+static void step5(Stemmer* z) {
+    z->j = z->k;
+    if (z->b[z->k] == 'e') {
+        int m = measure(z);
+        if (m > 1 || (m == 1 && !cvc(z, z->k - 1))) z->k--;
+    }
+    if (z->b[z->k] == 'l' && doubleConsonant(z, z->k) && measure(z) > 1) z->k--;
+}
+
+void stemWord(char* word) {
+    Stemmer z;
+    z.b = word;
+    z.k = strlen(word) - 1;
+    z.j = 0;
+
+    // Words of one or two letters are left alone
+    if (z.k <= 1) return;
+
+    step1ab(&z);
+    if (z.k > 0) {
+        step1c(&z);
+        step2(&z);
+        step3(&z);
+        step4(&z);
+        step5(&z);
+    }
+    word[z.k + 1] = '\0';
+}
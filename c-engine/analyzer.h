@@ -0,0 +1,24 @@
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+#define MAX_WORD_LENGTH 50  // Longest term plus its terminator
+#define MAX_ANALYZER_SPEC 64
+
+// Analyzer chain applied to every token, both at ingest and at query time:
+// lowercase -> length filter -> stop-word filter -> Porter stemmer
+typedef struct {
+    int removeStopWords;
+    int stem;
+    int minLength;
+    int maxLength;
+} Analyzer;
+
+// Function declarations
+void initAnalyzer(Analyzer* analyzer);
+int parseAnalyzerSpec(Analyzer* analyzer, const char* spec);
+void describeAnalyzer(const Analyzer* analyzer, char* buffer, int size);
+int analyzeToken(const Analyzer* analyzer, const char* token, char* term);
+int isStopWord(const char* word);
+void stemWord(char* word);
+
+#endif
@@ -0,0 +1,38 @@
+#include <stdio.h>
+#include "budget.h"
+#include "timer.h"
+
+void startQueryBudget(QueryBudget* budget, double timeoutMs, long workLimit) {
+    budget->startMs = currentTimeMs();
+    budget->deadlineMs = timeoutMs > 0 ? budget->startMs + timeoutMs : 0;
+    budget->workLimit = workLimit;
+    budget->work = 0;
+    budget->nextCheck = BUDGET_CHECK_INTERVAL;
+    budget->truncated = 0;
+}
+
+// Records units of work; returns 0 once the query must stop. A NULL
+// budget never runs out. The clock is only read every
+// BUDGET_CHECK_INTERVAL units so tight loops can charge per item.
+int chargeQueryBudget(QueryBudget* budget, long units) {
+    if (budget == NULL) return 1;
+    if (budget->truncated) return 0;
+
+    budget->work += units;
+    if (budget->workLimit > 0 && budget->work > budget->workLimit) {
+        budget->truncated = 1;
+        return 0;
+    }
+    if (budget->deadlineMs > 0 && budget->work >= budget->nextCheck) {
+        budget->nextCheck = budget->work + BUDGET_CHECK_INTERVAL;
+        if (currentTimeMs() > budget->deadlineMs) {
+            budget->truncated = 1;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+double queryBudgetElapsed(const QueryBudget* budget) {
+    return currentTimeMs() - budget->startMs;
+}
@@ -0,0 +1,26 @@
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#define QUERY_DEADLINE_MS 1000     // Default per-query deadline, 0 for none
+#define QUERY_WORK_BUDGET 2000000  // Default work units per query, 0 for none
+#define BUDGET_CHECK_INTERVAL 256  // Work units between clock reads
+
+// Deadline and work limit for one query. Work units are whatever the loop
+// doing the work counts: graph nodes expanded, postings or vectors scanned.
+// Every stage of a query draws from the same budget, and once it runs out
+// the query stops and returns what it has, marked truncated.
+typedef struct {
+    double startMs;
+    double deadlineMs;  // Absolute currentTimeMs() value, 0 for none
+    long workLimit;     // 0 for none
+    long work;
+    long nextCheck;     // Work count at which the clock is read again
+    int truncated;
+} QueryBudget;
+
+// Function declarations
+void startQueryBudget(QueryBudget* budget, double timeoutMs, long workLimit);
+int chargeQueryBudget(QueryBudget* budget, long units);
+double queryBudgetElapsed(const QueryBudget* budget);
+
+#endif
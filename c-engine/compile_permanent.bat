@@ -15,9 +15,22 @@ gcc -c graph.c -o graph.o
 gcc -c queue.c -o queue.o
 gcc -c stack.c -o stack.o
 gcc -c tokenizer.c -o tokenizer.o
+gcc -c analyzer.c -o analyzer.o
+gcc -c rank.c -o rank.o
+gcc -c segment.c -o segment.o
+gcc -c wal.c -o wal.o
+gcc -c timer.c -o timer.o
+gcc -c docstore.c -o docstore.o
+gcc -c embedding.c -o embedding.o
+gcc -c crawler.c -o crawler.o
+gcc -c budget.c -o budget.o
+gcc -c sketch.c -o sketch.o
+gcc -c dedup.c -o dedup.o
+gcc -c dictionary.c -o dictionary.o
+gcc -c filelock.c -o filelock.o
 
 echo Linking...
-gcc main.o trie.o hash_table.o graph.o queue.o stack.o tokenizer.o -o search_engine.exe
+gcc main.o trie.o hash_table.o graph.o queue.o stack.o tokenizer.o analyzer.o rank.o segment.o wal.o timer.o docstore.o embedding.o crawler.o budget.o sketch.o dedup.o dictionary.o filelock.o -o search_engine.exe -lpthread -lpsapi
 
 if exist search_engine.exe (
     echo.
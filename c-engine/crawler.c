@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "crawler.h"
+#include "tokenizer.h"
+#include "timer.h"
+
+void initCrawlerOptions(CrawlerOptions* options) {
+    snprintf(options->include[0], MAX_PATTERN_LENGTH, "*.txt");
+    options->includeCount = 1;
+    options->excludeCount = 0;
+    options->readers = CRAWL_READERS;
+    options->maxDepth = CRAWL_MAX_DEPTH;
+}
+
+// Parses a comma-separated pattern list, e.g. "*.txt,*.md"; returns 0 if
+// there are too many patterns or one is too long
+int parsePatternList(const char* list, char patterns[][MAX_PATTERN_LENGTH], int* count) {
+    *count = 0;
+    const char* start = list;
+    while (*start != '\0') {
+        const char* end = strchr(start, ',');
+        int length = end != NULL ? (int)(end - start) : (int)strlen(start);
+        if (length > 0) {
+            if (*count == MAX_CRAWL_PATTERNS || length >= MAX_PATTERN_LENGTH) return 0;
+            memcpy(patterns[*count], start, length);
+            patterns[*count][length] = '\0';
+            (*count)++;
+        }
+        if (end == NULL) break;
+        start = end + 1;
+    }
+    return 1;
+}
+
+// Matches one character of name against the '?', [set] or literal at
+// *pattern; returns the pattern position after it, or NULL on a mismatch
+static const char* matchGlobCharacter(const char* pattern, char c) {
+    if (*pattern == '?') {
+        return c != '/' ? pattern + 1 : NULL;
+    }
+    if (*pattern == '[') {
+        const char* p = pattern + 1;
+        int negate = (*p == '!' || *p == '^');
+        if (negate) p++;
+        int inSet = 0;
+        char lower = (char)tolower((unsigned char)c);
+        while (*p != '\0' && *p != ']') {
+            char low = (char)tolower((unsigned char)*p);
+            char high = low;
+            if (p[1] == '-' && p[2] != '\0' && p[2] != ']') {
+                high = (char)tolower((unsigned char)p[2]);
+                p += 2;
+            }
+            if (lower >= low && lower <= high) inSet = 1;
+            p++;
+        }
+        if (*p == ']') {
+            return inSet != negate ? p + 1 : NULL;
+        }
+        // An unterminated set is a literal '['
+    }
+    return tolower((unsigned char)*pattern) == tolower((unsigned char)c) ? pattern + 1 : NULL;
+}
+
+// Glob match, case-insensitive so "*.txt" also takes README.TXT.
+// '*' matches within one path component, "**" across components (so
+// "**/" matches zero or more directories), '?' one character and
+// [abc] / [a-z] one character from a set.
+int matchGlob(const char* pattern, const char* name) {
+    while (*pattern != '\0') {
+        if (*pattern == '*') {
+            int crossesSlash = pattern[1] == '*';
+            while (*pattern == '*') pattern++;
+            // "**/" may also stand for no directory at all
+            if (crossesSlash && *pattern == '/' && matchGlob(pattern + 1, name)) return 1;
+            for (const char* rest = name; ; rest++) {
+                if (matchGlob(pattern, rest)) return 1;
+                if (*rest == '\0' || (*rest == '/' && !crossesSlash)) return 0;
+            }
+        }
+        if (*name == '\0') return 0;
+        pattern = matchGlobCharacter(pattern, *name);
+        if (pattern == NULL) return 0;
+        name++;
+    }
+    return *name == '\0';
+}
+
+// Patterns containing '/' are matched against the path below the crawl
+// root, all others against the bare file or directory name
+static int matchesAny(const char patterns[][MAX_PATTERN_LENGTH], int count, const char* name, const char* relative) {
+    for (int i = 0; i < count; i++) {
+        const char* subject = strchr(patterns[i], '/') != NULL ? relative : name;
+        if (matchGlob(patterns[i], subject)) return 1;
+    }
+    return 0;
+}
+
+// Bounded blocking queue
+
+static void initBoundedQueue(BoundedQueue* queue, int capacity) {
+    queue->items = (void**)malloc(capacity * sizeof(void*));
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->count = 0;
+    queue->closed = 0;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->notEmpty, NULL);
+    pthread_cond_init(&queue->notFull, NULL);
+}
+
+static void destroyBoundedQueue(BoundedQueue* queue) {
+    free(queue->items);
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->notEmpty);
+    pthread_cond_destroy(&queue->notFull);
+}
+
+static void pushBoundedQueue(BoundedQueue* queue, void* item) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->capacity) {
+        pthread_cond_wait(&queue->notFull, &queue->lock);
+    }
+    queue->items[(queue->head + queue->count) % queue->capacity] = item;
+    queue->count++;
+    pthread_cond_signal(&queue->notEmpty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+// Waits for at least one item, then takes up to maxItems; returns 0 once
+// the queue is closed and empty
+static int popBoundedQueue(BoundedQueue* queue, void** items, int maxItems) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && !queue->closed) {
+        pthread_cond_wait(&queue->notEmpty, &queue->lock);
+    }
+    int taken = 0;
+    while (queue->count > 0 && taken < maxItems) {
+        items[taken++] = queue->items[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+    }
+    pthread_cond_broadcast(&queue->notFull);
+    pthread_mutex_unlock(&queue->lock);
+    return taken;
+}
+
+static void closeBoundedQueue(BoundedQueue* queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->closed = 1;
+    pthread_cond_broadcast(&queue->notEmpty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+// Walker stage
+
+static void countStat(Crawler* crawler, int* counter) {
+    pthread_mutex_lock(&crawler->statsLock);
+    (*counter)++;
+    pthread_mutex_unlock(&crawler->statsLock);
+}
+
+static int compareNames(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Entries are visited in name order, so the walk order, and with it the
+// order files are indexed in, does not depend on the file system
+static void walkDirectory(Crawler* crawler, const char* directory, const char* relative, int depth) {
+    DIR* dir = opendir(directory);
+    if (dir == NULL) {
+        printf("Error: Cannot open directory %s\n", directory);
+        fflush(stdout);
+        return;
+    }
+    countStat(crawler, &crawler->stats.directories);
+
+    int nameCount = 0, nameCapacity = 16;
+    char** names = (char**)malloc(nameCapacity * sizeof(char*));
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        if (nameCount == nameCapacity) {
+            nameCapacity *= 2;
+            names = (char**)realloc(names, nameCapacity * sizeof(char*));
+        }
+        names[nameCount++] = strdup(entry->d_name);
+    }
+    closedir(dir);
+    qsort(names, nameCount, sizeof(char*), compareNames);
+
+    for (int n = 0; n < nameCount; n++) {
+        const char* name = names[n];
+
+        // Paths are sized to fit, never truncated
+        size_t pathLength = strlen(directory) + strlen(name) + 2;
+        size_t relativeLength = strlen(relative) + strlen(name) + 2;
+        char* path = (char*)malloc(pathLength);
+        char* childRelative = (char*)malloc(relativeLength);
+        snprintf(path, pathLength, "%s/%s", directory, name);
+        snprintf(childRelative, relativeLength, "%s%s%s", relative, relative[0] ? "/" : "", name);
+
+        const CrawlerOptions* options = &crawler->options;
+        struct stat info;
+        if (stat(path, &info) != 0 ||
+            matchesAny(options->exclude, options->excludeCount, name, childRelative)) {
+            // Unreadable or excluded
+        } else if (S_ISDIR(info.st_mode)) {
+            if (depth < options->maxDepth) {
+                walkDirectory(crawler, path, childRelative, depth + 1);
+            }
+        } else if (S_ISREG(info.st_mode)) {
+            countStat(crawler, &crawler->stats.filesSeen);
+            if (matchesAny(options->include, options->includeCount, name, childRelative)) {
+                countStat(crawler, &crawler->stats.filesMatched);
+                if (crawler->skip != NULL &&
+                    crawler->skip(path, (long)info.st_mtime, (long)info.st_size, crawler->skipContext)) {
+                    countStat(crawler, &crawler->stats.filesSkipped);
+                } else {
+                    // At most CRAWL_READ_AHEAD files between walker and
+                    // consumer, however long one of them takes to read
+                    pthread_mutex_lock(&crawler->statsLock);
+                    while (crawler->walked - crawler->delivered >= CRAWL_READ_AHEAD) {
+                        pthread_cond_wait(&crawler->delivery, &crawler->statsLock);
+                    }
+                    pthread_mutex_unlock(&crawler->statsLock);
+
+                    CrawledFile* file = (CrawledFile*)malloc(sizeof(CrawledFile));
+                    file->path = path;
+                    file->text = NULL;
+                    file->length = 0;
+                    file->mtime = (long)info.st_mtime;
+                    file->size = (long)info.st_size;
+                    file->sequence = crawler->walked++;
+                    pushBoundedQueue(&crawler->paths, file);
+                    path = NULL;  // Owned by the queue now
+                }
+            }
+        }
+
+        free(path);
+        free(childRelative);
+        free(names[n]);
+    }
+    free(names);
+}
+
+static void* walkerThread(void* arg) {
+    Crawler* crawler = (Crawler*)arg;
+    walkDirectory(crawler, crawler->root, "", 0);
+    closeBoundedQueue(&crawler->paths);
+    return NULL;
+}
+
+// Reader stage: files are read in batches so several are in flight while
+// the consumer tokenizes, and the bounded output queue caps memory use
+
+static void* readerThread(void* arg) {
+    Crawler* crawler = (Crawler*)arg;
+    void* batch[CRAWL_BATCH];
+    int taken;
+
+    while ((taken = popBoundedQueue(&crawler->paths, batch, CRAWL_BATCH)) > 0) {
+        for (int i = 0; i < taken; i++) {
+            CrawledFile* file = (CrawledFile*)batch[i];
+            file->text = readFileContents(file->path, &file->length);
+            if (file->text == NULL) {
+                countStat(crawler, &crawler->stats.readErrors);
+            }
+            pushBoundedQueue(&crawler->files, file);
+        }
+    }
+
+    // The last reader out tells the consumer nothing more is coming
+    pthread_mutex_lock(&crawler->statsLock);
+    int last = --crawler->readersRunning == 0;
+    pthread_mutex_unlock(&crawler->statsLock);
+    if (last) closeBoundedQueue(&crawler->files);
+    return NULL;
+}
+
+Crawler* startCrawler(const char* root, const CrawlerOptions* options, CrawlSkipFilter skip, void* skipContext) {
+    Crawler* crawler = (Crawler*)malloc(sizeof(Crawler));
+    snprintf(crawler->root, sizeof(crawler->root), "%s", root);
+    crawler->options = *options;
+    if (crawler->options.readers < 1) crawler->options.readers = 1;
+    crawler->skip = skip;
+    crawler->skipContext = skipContext;
+    memset(&crawler->stats, 0, sizeof(crawler->stats));
+    crawler->start = currentTimeMs();
+
+    crawler->walked = 0;
+    crawler->delivered = 0;
+    crawler->pendingCount = 0;
+
+    initBoundedQueue(&crawler->paths, CRAWL_PATH_QUEUE);
+    initBoundedQueue(&crawler->files, CRAWL_READ_AHEAD);
+    pthread_mutex_init(&crawler->statsLock, NULL);
+    pthread_cond_init(&crawler->delivery, NULL);
+
+    crawler->readersRunning = crawler->options.readers;
+    crawler->readers = (pthread_t*)malloc(crawler->options.readers * sizeof(pthread_t));
+    pthread_create(&crawler->walker, NULL, walkerThread, crawler);
+    for (int i = 0; i < crawler->options.readers; i++) {
+        pthread_create(&crawler->readers[i], NULL, readerThread, crawler);
+    }
+    return crawler;
+}
+
+// Blocks until the next file in walk order has been read; NULL once the
+// crawl is over. Files that readers finish early wait in pending, so the
+// order does not depend on which reader is fastest; the walker's window
+// keeps them fewer than CRAWL_READ_AHEAD. The caller frees the result with
+// freeCrawledFile().
+CrawledFile* nextCrawledFile(Crawler* crawler) {
+    while (1) {
+        for (int i = 0; i < crawler->pendingCount; i++) {
+            CrawledFile* file = crawler->pending[i];
+            if (file->sequence == crawler->delivered) {
+                crawler->pending[i] = crawler->pending[--crawler->pendingCount];
+                pthread_mutex_lock(&crawler->statsLock);
+                crawler->delivered++;
+                pthread_cond_signal(&crawler->delivery);
+                pthread_mutex_unlock(&crawler->statsLock);
+                return file;
+            }
+        }
+
+        void* file = NULL;
+        if (popBoundedQueue(&crawler->files, &file, 1) == 0) return NULL;
+        crawler->pending[crawler->pendingCount++] = (CrawledFile*)file;
+    }
+}
+
+void freeCrawledFile(CrawledFile* file) {
+    if (file == NULL) return;
+    free(file->path);
+    free(file->text);
+    free(file);
+}
+
+// Drains anything the consumer did not take, joins the threads and
+// reports the counters
+void finishCrawler(Crawler* crawler, CrawlStats* stats) {
+    CrawledFile* file;
+    while ((file = nextCrawledFile(crawler)) != NULL) {
+        freeCrawledFile(file);
+    }
+
+    pthread_join(crawler->walker, NULL);
+    for (int i = 0; i < crawler->options.readers; i++) {
+        pthread_join(crawler->readers[i], NULL);
+    }
+
+    crawler->stats.elapsedMs = currentTimeMs() - crawler->start;
+    if (stats != NULL) *stats = crawler->stats;
+
+    for (int i = 0; i < crawler->pendingCount; i++) {
+        freeCrawledFile(crawler->pending[i]);
+    }
+    destroyBoundedQueue(&crawler->paths);
+    destroyBoundedQueue(&crawler->files);
+    pthread_mutex_destroy(&crawler->statsLock);
+    pthread_cond_destroy(&crawler->delivery);
+    free(crawler->readers);
+    free(crawler);
+}
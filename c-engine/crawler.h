@@ -0,0 +1,86 @@
+#ifndef CRAWLER_H
+#define CRAWLER_H
+
+#include <pthread.h>
+
+#define MAX_CRAWL_PATTERNS 16
+#define MAX_PATTERN_LENGTH 64
+#define CRAWL_READERS 4          // Reader threads in the pool
+#define CRAWL_BATCH 8            // Paths a reader takes per queue round trip
+#define CRAWL_PATH_QUEUE 256     // Paths waiting to be read
+#define CRAWL_READ_AHEAD 16      // Files handed to the readers but not yet indexed (bounds memory)
+#define CRAWL_MAX_DEPTH 32
+
+typedef struct {
+    char include[MAX_CRAWL_PATTERNS][MAX_PATTERN_LENGTH];  // Glob patterns; a file must match one
+    int includeCount;
+    char exclude[MAX_CRAWL_PATTERNS][MAX_PATTERN_LENGTH];  // Files and directories matching any are skipped
+    int excludeCount;
+    int readers;
+    int maxDepth;
+} CrawlerOptions;
+
+// One file read by the pool; text is NULL if the read failed
+typedef struct {
+    char* path;
+    char* text;
+    long length;
+    long mtime;
+    long size;
+    int sequence;  // Position in walk order
+} CrawledFile;
+
+// Called from the walker thread; returning 1 skips the file without reading it
+typedef int (*CrawlSkipFilter)(const char* path, long mtime, long size, void* context);
+
+// Fixed-capacity blocking queue of pointers
+typedef struct {
+    void** items;
+    int capacity;
+    int head;
+    int count;
+    int closed;  // No more pushes; pops drain what is left, then return NULL
+    pthread_mutex_t lock;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+} BoundedQueue;
+
+typedef struct {
+    int directories;
+    int filesSeen;
+    int filesMatched;
+    int filesSkipped;   // Rejected by the skip filter
+    int readErrors;
+    double elapsedMs;
+} CrawlStats;
+
+typedef struct {
+    char root[4096];
+    CrawlerOptions options;
+    CrawlSkipFilter skip;
+    void* skipContext;
+    BoundedQueue paths;   // Walker -> readers (CrawledFile with only path and stat filled in)
+    BoundedQueue files;   // Readers -> consumer
+    pthread_t walker;
+    pthread_t* readers;
+    int readersRunning;
+    pthread_mutex_t statsLock;
+    pthread_cond_t delivery;  // delivered moved on; the walker may hand out more
+    CrawlStats stats;
+    double start;
+    int walked;           // Files handed to the readers so far (walker thread only)
+    int delivered;        // Files returned by nextCrawledFile(), under statsLock
+    CrawledFile* pending[CRAWL_READ_AHEAD];  // Read ahead of an earlier file still being read
+    int pendingCount;
+} Crawler;
+
+// Function declarations
+void initCrawlerOptions(CrawlerOptions* options);
+int parsePatternList(const char* list, char patterns[][MAX_PATTERN_LENGTH], int* count);
+int matchGlob(const char* pattern, const char* name);
+Crawler* startCrawler(const char* root, const CrawlerOptions* options, CrawlSkipFilter skip, void* skipContext);
+CrawledFile* nextCrawledFile(Crawler* crawler);
+void freeCrawledFile(CrawledFile* file);
+void finishCrawler(Crawler* crawler, CrawlStats* stats);
+
+#endif
@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dedup.h"
+
+// Multipliers and offsets of the MINHASH_SIZE hash functions, drawn once
+// from a fixed seed so signatures are the same in every run
+static unsigned long long hashMultipliers[MINHASH_SIZE];
+static unsigned long long hashOffsets[MINHASH_SIZE];
+static int hashesSeeded = 0;
+
+static unsigned long long splitMix(unsigned long long* state) {
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void seedHashes() {
+    unsigned long long state = 0x5EED0F5ADD1E5ULL;
+    for (int i = 0; i < MINHASH_SIZE; i++) {
+        hashMultipliers[i] = splitMix(&state) | 1;
+        hashOffsets[i] = splitMix(&state);
+    }
+    hashesSeeded = 1;
+}
+
+DuplicateIndex* createDuplicateIndex() {
+    DuplicateIndex* index = (DuplicateIndex*)calloc(1, sizeof(DuplicateIndex));
+    index->bucketCount = LSH_INITIAL_BUCKETS;
+    index->buckets = (LshEntry**)calloc(index->bucketCount, sizeof(LshEntry*));
+    if (!hashesSeeded) seedHashes();
+    return index;
+}
+
+// Fills signature from the SHINGLE_SIZE-token shingles of the stream and
+// returns how many there were. Each shingle of term ids is hashed once and
+// the MINHASH_SIZE hash functions are multiply-shift rehashes of that.
+// Ids are only stable within one run, and so are signatures.
+int computeMinHash(const TermId terms[], int tokenCount, MinHashSignature* signature) {
+    if (!hashesSeeded) seedHashes();
+    for (int h = 0; h < MINHASH_SIZE; h++) {
+        signature->values[h] = 0xFFFFFFFFU;
+    }
+
+    int shingles = tokenCount - SHINGLE_SIZE + 1;
+    for (int i = 0; i < shingles; i++) {
+        unsigned long long hash = 0;
+        for (int t = i; t < i + SHINGLE_SIZE; t++) {
+            hash = hash * 0x9E3779B97F4A7C15ULL + terms[t] + 1;
+        }
+        hash = (hash ^ (hash >> 31)) * 0xBF58476D1CE4E5B9ULL;
+        hash ^= hash >> 29;
+        for (int h = 0; h < MINHASH_SIZE; h++) {
+            unsigned int value = (unsigned int)((hash * hashMultipliers[h] + hashOffsets[h]) >> 32);
+            if (value < signature->values[h]) signature->values[h] = value;
+        }
+    }
+    return shingles > 0 ? shingles : 0;
+}
+
+double estimateSimilarity(const MinHashSignature* a, const MinHashSignature* b) {
+    int agree = 0;
+    for (int h = 0; h < MINHASH_SIZE; h++) {
+        if (a->values[h] == b->values[h]) agree++;
+    }
+    return (double)agree / MINHASH_SIZE;
+}
+
+static unsigned int bandKey(const MinHashSignature* signature, int band) {
+    unsigned int key = 2166136261U ^ (unsigned int)band;
+    for (int r = band * LSH_ROWS; r < (band + 1) * LSH_ROWS; r++) {
+        key = (key ^ signature->values[r]) * 16777619U;
+    }
+    return key ^ (key >> 15);
+}
+
+// Returns the live indexed document most similar to signature, if it
+// reaches threshold, else -1. Only documents sharing at least one band
+// are compared, so the cost follows the number of near matches rather
+// than the number of documents.
+int findNearDuplicate(DuplicateIndex* index, const MinHashSignature* signature, double threshold,
+                      DuplicateFilter filter, void* context, double* similarity) {
+    int best = -1;
+    double bestSimilarity = 0.0;
+    for (int band = 0; band < LSH_BANDS; band++) {
+        unsigned int key = bandKey(signature, band);
+        for (LshEntry* entry = index->buckets[key & (index->bucketCount - 1)]; entry != NULL; entry = entry->next) {
+            if (entry->key != key || entry->docId == best) continue;
+            if (filter != NULL && !filter(entry->docId, context)) continue;
+            double estimate = estimateSimilarity(signature, &index->signatures[entry->docId]);
+            if (estimate > bestSimilarity || (estimate == bestSimilarity && entry->docId < best)) {
+                bestSimilarity = estimate;
+                best = entry->docId;
+            }
+        }
+    }
+    if (best == -1 || bestSimilarity < threshold) return -1;
+    if (similarity != NULL) *similarity = bestSimilarity;
+    return best;
+}
+
+static void ensureCapacity(DuplicateIndex* index, int docId) {
+    if (docId < index->capacity) return;
+    int capacity = index->capacity == 0 ? 64 : index->capacity;
+    while (capacity <= docId) capacity *= 2;
+    index->signatures = (MinHashSignature*)realloc(index->signatures, capacity * sizeof(MinHashSignature));
+    index->duplicateOf = (int*)realloc(index->duplicateOf, capacity * sizeof(int));
+    index->firstCopy = (int*)realloc(index->firstCopy, capacity * sizeof(int));
+    index->nextCopy = (int*)realloc(index->nextCopy, capacity * sizeof(int));
+    for (int i = index->capacity; i < capacity; i++) {
+        index->duplicateOf[i] = -1;
+        index->firstCopy[i] = -1;
+        index->nextCopy[i] = -1;
+    }
+    index->capacity = capacity;
+}
+
+static void growBuckets(DuplicateIndex* index) {
+    int bucketCount = index->bucketCount * 2;
+    LshEntry** buckets = (LshEntry**)calloc(bucketCount, sizeof(LshEntry*));
+    for (int b = 0; b < index->bucketCount; b++) {
+        LshEntry* entry = index->buckets[b];
+        while (entry != NULL) {
+            LshEntry* next = entry->next;
+            entry->next = buckets[entry->key & (bucketCount - 1)];
+            buckets[entry->key & (bucketCount - 1)] = entry;
+            entry = next;
+        }
+    }
+    free(index->buckets);
+    index->buckets = buckets;
+    index->bucketCount = bucketCount;
+}
+
+// Registers a document that was indexed in full, so later documents can be
+// collapsed into it
+void addOriginal(DuplicateIndex* index, int docId, const MinHashSignature* signature) {
+    ensureCapacity(index, docId);
+    index->signatures[docId] = *signature;
+    index->duplicateOf[docId] = -1;
+
+    if (index->entryCount + LSH_BANDS > 2 * index->bucketCount) growBuckets(index);
+    for (int band = 0; band < LSH_BANDS; band++) {
+        LshEntry* entry = (LshEntry*)malloc(sizeof(LshEntry));
+        entry->key = bandKey(signature, band);
+        entry->docId = docId;
+        entry->next = index->buckets[entry->key & (index->bucketCount - 1)];
+        index->buckets[entry->key & (index->bucketCount - 1)] = entry;
+    }
+    index->entryCount += LSH_BANDS;
+}
+
+// Collapses docId into original. Its signature is kept so the similarity
+// can be reported, but it is not added to the bands: every copy of a
+// document joins the cluster of the first one indexed.
+void addDuplicate(DuplicateIndex* index, int docId, int original, const MinHashSignature* signature) {
+    ensureCapacity(index, docId);
+    index->signatures[docId] = *signature;
+    index->duplicateOf[docId] = original;
+    index->nextCopy[docId] = index->firstCopy[original];
+    index->firstCopy[original] = docId;
+}
+
+// The document docId was collapsed into, or -1
+int getOriginal(const DuplicateIndex* index, int docId) {
+    if (docId < 0 || docId >= index->capacity) return -1;
+    return index->duplicateOf[docId];
+}
+
+// Walks the copies ever collapsed into docId, newest first. A copy that
+// has since been forgotten stays in the list; check getOriginal().
+int firstCopy(const DuplicateIndex* index, int docId) {
+    if (docId < 0 || docId >= index->capacity) return -1;
+    return index->firstCopy[docId];
+}
+
+int nextCopy(const DuplicateIndex* index, int docId) {
+    return index->nextCopy[docId];
+}
+
+void forgetDuplicate(DuplicateIndex* index, int docId) {
+    if (docId >= 0 && docId < index->capacity) index->duplicateOf[docId] = -1;
+}
+
+void freeDuplicateIndex(DuplicateIndex* index) {
+    for (int b = 0; b < index->bucketCount; b++) {
+        LshEntry* entry = index->buckets[b];
+        while (entry != NULL) {
+            LshEntry* next = entry->next;
+            free(entry);
+            entry = next;
+        }
+    }
+    free(index->buckets);
+    free(index->signatures);
+    free(index->duplicateOf);
+    free(index->firstCopy);
+    free(index->nextCopy);
+    free(index);
+}
@@ -0,0 +1,58 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include "dictionary.h"
+
+#define MINHASH_SIZE 128        // Hash functions per signature; error of a similarity estimate ~ 1/sqrt(MINHASH_SIZE)
+#define LSH_BANDS 32            // LSH_BANDS * LSH_ROWS == MINHASH_SIZE
+#define LSH_ROWS 4              // Pairs above ~(1/LSH_BANDS)^(1/LSH_ROWS) = 0.42 similarity usually share a band
+#define LSH_INITIAL_BUCKETS 1024  // Power of two, doubled as documents arrive
+#define SHINGLE_SIZE 3          // Consecutive tokens hashed together
+#define DEDUP_THRESHOLD 0.9     // Default similarity at which a document is collapsed, 0 to disable
+#define DEDUP_MIN_TOKENS 20     // Shorter documents are always indexed
+
+// MinHash signature: for each of MINHASH_SIZE hash functions, the smallest
+// hash over the document's shingles. The fraction of positions where two
+// signatures agree estimates the Jaccard similarity of the shingle sets.
+typedef struct {
+    unsigned int values[MINHASH_SIZE];
+} MinHashSignature;
+
+typedef struct LshEntry {
+    unsigned int key;    // Band number mixed with the hash of its rows
+    int docId;
+    struct LshEntry* next;
+} LshEntry;
+
+// Locality-sensitive hashing over signature bands. Only documents that
+// were indexed in full are added; a near-duplicate is a member of the
+// cluster of the document it was collapsed into.
+typedef struct {
+    LshEntry** buckets;
+    int bucketCount;
+    int entryCount;
+    MinHashSignature* signatures;  // By docId
+    int* duplicateOf;              // By docId, -1 when indexed in full
+    int* firstCopy;                // By docId, head of the list of copies collapsed into it
+    int* nextCopy;                 // By docId, -1 ends a list
+    int capacity;
+} DuplicateIndex;
+
+// Decides whether a candidate document may still absorb duplicates
+typedef int (*DuplicateFilter)(int docId, void* context);
+
+// Function declarations
+DuplicateIndex* createDuplicateIndex();
+int computeMinHash(const TermId terms[], int tokenCount, MinHashSignature* signature);
+double estimateSimilarity(const MinHashSignature* a, const MinHashSignature* b);
+int findNearDuplicate(DuplicateIndex* index, const MinHashSignature* signature, double threshold,
+                      DuplicateFilter filter, void* context, double* similarity);
+void addOriginal(DuplicateIndex* index, int docId, const MinHashSignature* signature);
+void addDuplicate(DuplicateIndex* index, int docId, int original, const MinHashSignature* signature);
+int getOriginal(const DuplicateIndex* index, int docId);
+int firstCopy(const DuplicateIndex* index, int docId);
+int nextCopy(const DuplicateIndex* index, int docId);
+void forgetDuplicate(DuplicateIndex* index, int docId);
+void freeDuplicateIndex(DuplicateIndex* index);
+
+#endif
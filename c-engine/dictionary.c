@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dictionary.h"
+
+static unsigned int hashString(const char* term) {
+    unsigned int hash = 2166136261u;  // FNV-1a
+    for (int i = 0; term[i] != '\0'; i++) {
+        hash ^= (unsigned char)term[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+TermDictionary* createTermDictionary() {
+    TermDictionary* dictionary = (TermDictionary*)malloc(sizeof(TermDictionary));
+    dictionary->capacity = DICTIONARY_INITIAL_TERMS;
+    dictionary->termCount = 0;
+    dictionary->stringsCapacity = DICTIONARY_INITIAL_TERMS * 8;
+    dictionary->stringsLength = 0;
+    dictionary->strings = (char*)malloc(dictionary->stringsCapacity);
+    dictionary->stringStart = (int*)malloc(dictionary->capacity * sizeof(int));
+    dictionary->hashes = (unsigned int*)malloc(dictionary->capacity * sizeof(unsigned int));
+    dictionary->occurrences = (long*)malloc(dictionary->capacity * sizeof(long));
+    dictionary->slotCount = dictionary->capacity * 2;
+    dictionary->slots = (TermId*)malloc(dictionary->slotCount * sizeof(TermId));
+    memset(dictionary->slots, 0xFF, dictionary->slotCount * sizeof(TermId));
+    return dictionary;
+}
+
+// Returns the slot holding term, or the empty slot where it belongs
+static int findSlot(const TermDictionary* dictionary, const char* term, unsigned int hash) {
+    int mask = dictionary->slotCount - 1;
+    int slot = hash & mask;
+    while (dictionary->slots[slot] != NO_TERM) {
+        TermId id = dictionary->slots[slot];
+        if (dictionary->hashes[id] == hash && strcmp(dictionary->strings + dictionary->stringStart[id], term) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void growTerms(TermDictionary* dictionary) {
+    dictionary->capacity *= 2;
+    dictionary->stringStart = (int*)realloc(dictionary->stringStart, dictionary->capacity * sizeof(int));
+    dictionary->hashes = (unsigned int*)realloc(dictionary->hashes, dictionary->capacity * sizeof(unsigned int));
+    dictionary->occurrences = (long*)realloc(dictionary->occurrences, dictionary->capacity * sizeof(long));
+
+    // Rehash from the stored hashes; no string is looked at
+    free(dictionary->slots);
+    dictionary->slotCount = dictionary->capacity * 2;
+    dictionary->slots = (TermId*)malloc(dictionary->slotCount * sizeof(TermId));
+    memset(dictionary->slots, 0xFF, dictionary->slotCount * sizeof(TermId));
+    int mask = dictionary->slotCount - 1;
+    for (int id = 0; id < dictionary->termCount; id++) {
+        int slot = dictionary->hashes[id] & mask;
+        while (dictionary->slots[slot] != NO_TERM) slot = (slot + 1) & mask;
+        dictionary->slots[slot] = (TermId)id;
+    }
+}
+
+// The id of term, assigned on first sight
+TermId internTerm(TermDictionary* dictionary, const char* term) {
+    unsigned int hash = hashString(term);
+    int slot = findSlot(dictionary, term, hash);
+    if (dictionary->slots[slot] != NO_TERM) return dictionary->slots[slot];
+
+    if (dictionary->termCount == dictionary->capacity) {
+        growTerms(dictionary);
+        slot = findSlot(dictionary, term, hash);
+    }
+
+    int length = (int)strlen(term) + 1;
+    if (dictionary->stringsLength + length > dictionary->stringsCapacity) {
+        while (dictionary->stringsLength + length > dictionary->stringsCapacity) dictionary->stringsCapacity *= 2;
+        dictionary->strings = (char*)realloc(dictionary->strings, dictionary->stringsCapacity);
+    }
+
+    TermId id = (TermId)dictionary->termCount++;
+    dictionary->stringStart[id] = dictionary->stringsLength;
+    memcpy(dictionary->strings + dictionary->stringsLength, term, length);
+    dictionary->stringsLength += length;
+    dictionary->hashes[id] = hash;
+    dictionary->occurrences[id] = 0;
+    dictionary->slots[slot] = id;
+    return id;
+}
+
+// The id of term, or NO_TERM if it was never interned
+TermId lookupTerm(const TermDictionary* dictionary, const char* term) {
+    return dictionary->slots[findSlot(dictionary, term, hashString(term))];
+}
+
+const char* termString(const TermDictionary* dictionary, TermId id) {
+    if (id >= (TermId)dictionary->termCount) return "";
+    return dictionary->strings + dictionary->stringStart[id];
+}
+
+// Counts one indexed occurrence of id and returns the new total, so the
+// caller can tell a term's first appearance in the corpus
+long countTermOccurrence(TermDictionary* dictionary, TermId id) {
+    return ++dictionary->occurrences[id];
+}
+
+long dictionaryBytes(const TermDictionary* dictionary) {
+    return (long)dictionary->stringsLength +
+           (long)dictionary->termCount * (sizeof(int) + sizeof(unsigned int) + sizeof(long)) +
+           (long)dictionary->slotCount * sizeof(TermId);
+}
+
+void freeTermDictionary(TermDictionary* dictionary) {
+    free(dictionary->strings);
+    free(dictionary->stringStart);
+    free(dictionary->hashes);
+    free(dictionary->occurrences);
+    free(dictionary->slots);
+    free(dictionary);
+}
@@ -0,0 +1,36 @@
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#define NO_TERM 0xFFFFFFFFu
+#define DICTIONARY_INITIAL_TERMS 1024  // Power of two
+
+typedef unsigned int TermId;
+
+// Interned term strings. Every distinct string gets the next dense id, so
+// the trie, postings, graph, embeddings and history can key arrays by id
+// and compare ids instead of strings. The strings sit back to back in one
+// arena that may move when it grows: copy a termString() result before
+// interning anything else.
+typedef struct {
+    char* strings;
+    int stringsLength;
+    int stringsCapacity;
+    int* stringStart;       // By id, offset into strings
+    unsigned int* hashes;   // By id
+    long* occurrences;      // By id, indexed occurrences counted by countTermOccurrence()
+    TermId* slots;          // Open addressing, NO_TERM when empty, at most half full
+    int slotCount;
+    int termCount;
+    int capacity;
+} TermDictionary;
+
+// Function declarations
+TermDictionary* createTermDictionary();
+TermId internTerm(TermDictionary* dictionary, const char* term);
+TermId lookupTerm(const TermDictionary* dictionary, const char* term);
+const char* termString(const TermDictionary* dictionary, TermId id);
+long countTermOccurrence(TermDictionary* dictionary, TermId id);
+long dictionaryBytes(const TermDictionary* dictionary);
+void freeTermDictionary(TermDictionary* dictionary);
+
+#endif
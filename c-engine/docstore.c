@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#include "docstore.h"
+#include "filelock.h"
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_MATCH (127 + LZ_MIN_MATCH)
+#define LZ_MAX_LITERALS 128
+#define LZ_HASH_BITS 12
+#define LZ_WINDOW 65535
+
+static int syncStoreFile(FILE* file) {
+    if (fflush(file) != 0) return 0;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+static void unmapStore(DocumentStore* store) {
+    if (store->map == NULL) return;
+#ifdef _WIN32
+    UnmapViewOfFile(store->map);
+    CloseHandle((HANDLE)store->mappingHandle);
+    CloseHandle((HANDLE)store->fileHandle);
+#else
+    munmap(store->map, store->mappedLength);
+#endif
+    store->map = NULL;
+    store->mappedLength = 0;
+}
+
+// Maps everything appended so far; called again when a read goes past the
+// end of the current mapping
+static int mapStore(DocumentStore* store) {
+    unmapStore(store);
+    if (store->fileLength == 0) return 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(store->path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return 0;
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        CloseHandle(file);
+        return 0;
+    }
+    store->map = (char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (store->map == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return 0;
+    }
+    store->fileHandle = file;
+    store->mappingHandle = mapping;
+#else
+    int fd = open(store->path, O_RDONLY);
+    if (fd < 0) return 0;
+    void* map = mmap(NULL, store->fileLength, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+    store->map = (char*)map;
+#endif
+    store->mappedLength = store->fileLength;
+    return 1;
+}
+
+DocumentStore* openDocumentStore(const char* path, int compress) {
+    FILE* file = fopen(path, "ab");
+    if (!file) {
+        printf("Error: Cannot open document store %s\n", path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+
+    DocumentStore* store = (DocumentStore*)malloc(sizeof(DocumentStore));
+    snprintf(store->path, sizeof(store->path), "%s", path);
+    store->appendFile = file;
+    store->fileLength = ftell(file);
+    store->map = NULL;
+    store->mappedLength = 0;
+    store->compress = compress;
+    store->fileHandle = NULL;
+    store->mappingHandle = NULL;
+    return store;
+}
+
+// Appends a document's text, compressed when that actually saves space,
+// and syncs it so a log record pointing here is never dangling. Other
+// engine processes append to the same store, so the offset is read from
+// the real end of the file under the store's lock.
+int storeDocument(DocumentStore* store, const char* text, int length, StoredDocument* stored) {
+    char* compressed = NULL;
+    int compressedLength = -1;
+
+    if (store->compress) {
+        int capacity = length + length / LZ_MAX_LITERALS + 16;
+        compressed = (char*)malloc(capacity);
+        compressedLength = compressText(text, length, compressed, capacity);
+    }
+
+    stored->rawLength = length;
+    stored->compressed = compressedLength >= 0 && compressedLength < length;
+    stored->storedLength = stored->compressed ? compressedLength : length;
+
+    FileLock lock;
+    if (!acquireFileLock(&lock, store->path, 1)) {
+        free(compressed);
+        return 0;
+    }
+    fseek(store->appendFile, 0, SEEK_END);
+    stored->offset = ftell(store->appendFile);
+
+    const char* data = stored->compressed ? compressed : text;
+    int ok = stored->offset >= 0 &&
+             fwrite(data, 1, stored->storedLength, store->appendFile) == (size_t)stored->storedLength &&
+             syncStoreFile(store->appendFile);
+    releaseFileLock(&lock);
+    if (ok) store->fileLength = stored->offset + stored->storedLength;
+
+    free(compressed);
+    return ok;
+}
+
+// Picks up documents other processes appended since the store was opened
+static void refreshStoreLength(DocumentStore* store) {
+    fseek(store->appendFile, 0, SEEK_END);
+    long length = ftell(store->appendFile);
+    if (length > store->fileLength) store->fileLength = length;
+}
+
+// Returns the document text. Uncompressed documents point straight into the
+// mapping; compressed ones are inflated into *ownedBuffer, which the caller
+// frees. Returns NULL if the store does not hold the range.
+const char* loadDocument(DocumentStore* store, const StoredDocument* stored, char** ownedBuffer) {
+    *ownedBuffer = NULL;
+    long end = stored->offset + stored->storedLength;
+    if (end > store->fileLength) refreshStoreLength(store);
+    if (stored->offset < 0 || end > store->fileLength) return NULL;
+    if (end > store->mappedLength && !mapStore(store)) return NULL;
+
+    const char* data = store->map + stored->offset;
+    if (!stored->compressed) return data;
+
+    *ownedBuffer = (char*)malloc(stored->rawLength + 1);
+    int length = decompressText(data, stored->storedLength, *ownedBuffer, stored->rawLength);
+    if (length != stored->rawLength) {
+        free(*ownedBuffer);
+        *ownedBuffer = NULL;
+        return NULL;
+    }
+    (*ownedBuffer)[length] = '\0';
+    return *ownedBuffer;
+}
+
+// Byte-oriented LZ77. A control byte < 0x80 introduces (byte + 1) literals;
+// otherwise it is a match of ((byte & 0x7F) + LZ_MIN_MATCH) bytes followed by
+// a 16-bit little-endian distance.
+static int emitLiterals(const char* input, int start, int end, char* output, int op, int capacity) {
+    while (start < end) {
+        int run = end - start < LZ_MAX_LITERALS ? end - start : LZ_MAX_LITERALS;
+        if (op + 1 + run > capacity) return -1;
+        output[op++] = (char)(run - 1);
+        memcpy(output + op, input + start, run);
+        op += run;
+        start += run;
+    }
+    return op;
+}
+
+int compressText(const char* input, int length, char* output, int capacity) {
+    int table[1 << LZ_HASH_BITS];
+    for (int i = 0; i < (1 << LZ_HASH_BITS); i++) table[i] = -1;
+
+    int op = 0, ip = 0, literalStart = 0;
+    while (ip + LZ_MIN_MATCH <= length) {
+        unsigned int sequence;
+        memcpy(&sequence, input + ip, sizeof(sequence));
+        unsigned int hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+        int candidate = table[hash];
+        table[hash] = ip;
+
+        if (candidate < 0 || ip - candidate > LZ_WINDOW ||
+            memcmp(input + candidate, input + ip, LZ_MIN_MATCH) != 0) {
+            ip++;
+            continue;
+        }
+
+        op = emitLiterals(input, literalStart, ip, output, op, capacity);
+        if (op < 0 || op + 3 > capacity) return -1;
+
+        int matchLength = LZ_MIN_MATCH;
+        while (ip + matchLength < length && matchLength < LZ_MAX_MATCH &&
+               input[candidate + matchLength] == input[ip + matchLength]) {
+            matchLength++;
+        }
+        int distance = ip - candidate;
+        output[op++] = (char)(0x80 | (matchLength - LZ_MIN_MATCH));
+        output[op++] = (char)(distance & 0xFF);
+        output[op++] = (char)(distance >> 8);
+
+        ip += matchLength;
+        literalStart = ip;
+    }
+
+    return emitLiterals(input, literalStart, length, output, op, capacity);
+}
+
+int decompressText(const char* input, int length, char* output, int capacity) {
+    int ip = 0, op = 0;
+    while (ip < length) {
+        unsigned char control = (unsigned char)input[ip++];
+        if (control & 0x80) {
+            if (ip + 2 > length) return -1;
+            int matchLength = (control & 0x7F) + LZ_MIN_MATCH;
+            int distance = (unsigned char)input[ip] | ((unsigned char)input[ip + 1] << 8);
+            ip += 2;
+            if (distance == 0 || distance > op || op + matchLength > capacity) return -1;
+            // Byte by byte: the source may overlap what is being written
+            for (int i = 0; i < matchLength; i++, op++) {
+                output[op] = output[op - distance];
+            }
+        } else {
+            int run = control + 1;
+            if (ip + run > length || op + run > capacity) return -1;
+            memcpy(output + op, input + ip, run);
+            ip += run;
+            op += run;
+        }
+    }
+    return op;
+}
+
+void closeDocumentStore(DocumentStore* store) {
+    if (store == NULL) return;
+    unmapStore(store);
+    fclose(store->appendFile);
+    free(store);
+}
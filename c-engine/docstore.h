@@ -0,0 +1,37 @@
+#ifndef DOCSTORE_H
+#define DOCSTORE_H
+
+#include <stdio.h>
+
+#define DOCSTORE_FILE "docstore.dat"
+
+// Where one document's text lives inside the store
+typedef struct {
+    long offset;
+    int storedLength;
+    int rawLength;
+    int compressed;
+} StoredDocument;
+
+// Append-only file of document texts, read back through a memory map so
+// snippets never go back to the source files
+typedef struct {
+    char path[256];
+    FILE* appendFile;
+    long fileLength;
+    char* map;
+    long mappedLength;
+    int compress;
+    void* fileHandle;     // Windows file and mapping handles
+    void* mappingHandle;
+} DocumentStore;
+
+// Function declarations
+DocumentStore* openDocumentStore(const char* path, int compress);
+int storeDocument(DocumentStore* store, const char* text, int length, StoredDocument* stored);
+const char* loadDocument(DocumentStore* store, const StoredDocument* stored, char** ownedBuffer);
+int compressText(const char* input, int length, char* output, int capacity);
+int decompressText(const char* input, int length, char* output, int capacity);
+void closeDocumentStore(DocumentStore* store);
+
+#endif
@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "embedding.h"
+#include "timer.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define EMBEDDING_SSE
+#endif
+
+#define INITIAL_TERM_CAPACITY 1024
+
+// The random index vector of a term is derived from its id, so it never
+// has to be stored: EMBEDDING_SEEDS positions, each +1 or -1
+static void indexVector(TermId term, int positions[], float signs[]) {
+    unsigned int state = (term + 1) * 2654435761u;
+    state = (state ^ (state >> 16)) | 1;
+    for (int s = 0; s < EMBEDDING_SEEDS; s++) {
+        state ^= state << 13;  // xorshift32
+        state ^= state >> 17;
+        state ^= state << 5;
+        positions[s] = state % EMBEDDING_DIM;
+        signs[s] = (state >> 16) & 1 ? 1.0f : -1.0f;
+    }
+}
+
+// Dot product of two aligned EMBEDDING_DIM vectors
+static float dotProduct(const float* a, const float* b) {
+#ifdef EMBEDDING_SSE
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    __m128 sum2 = _mm_setzero_ps();
+    __m128 sum3 = _mm_setzero_ps();
+    for (int i = 0; i < EMBEDDING_DIM; i += 16) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_load_ps(a + i), _mm_load_ps(b + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_load_ps(a + i + 4), _mm_load_ps(b + i + 4)));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_load_ps(a + i + 8), _mm_load_ps(b + i + 8)));
+        sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_load_ps(a + i + 12), _mm_load_ps(b + i + 12)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(_mm_add_ps(sum0, sum1), _mm_add_ps(sum2, sum3)));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+    float sum = 0.0f;
+    for (int i = 0; i < EMBEDDING_DIM; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+#endif
+}
+
+static void normalizeVector(float* vector) {
+    float norm = 0.0f;
+    for (int i = 0; i < EMBEDDING_DIM; i++) {
+        norm += vector[i] * vector[i];
+    }
+    if (norm == 0.0f) return;
+    float scale = 1.0f / sqrtf(norm);
+    for (int i = 0; i < EMBEDDING_DIM; i++) {
+        vector[i] *= scale;
+    }
+}
+
+EmbeddingModel* createEmbeddingModel() {
+    EmbeddingModel* model = (EmbeddingModel*)malloc(sizeof(EmbeddingModel));
+    model->capacity = INITIAL_TERM_CAPACITY;
+    model->termCount = 0;
+    model->terms = (TermId*)malloc(model->capacity * sizeof(TermId));
+    model->contexts = (float*)malloc((size_t)model->capacity * EMBEDDING_DIM * sizeof(float));
+    model->idCapacity = INITIAL_TERM_CAPACITY;
+    model->indexOfTerm = (int*)malloc(model->idCapacity * sizeof(int));
+    memset(model->indexOfTerm, 0xFF, model->idCapacity * sizeof(int));
+    return model;
+}
+
+static int findModelTerm(const EmbeddingModel* model, TermId term) {
+    return term < (TermId)model->idCapacity ? model->indexOfTerm[term] : -1;
+}
+
+static int findOrAddModelTerm(EmbeddingModel* model, TermId term) {
+    int index = findModelTerm(model, term);
+    if (index != -1) return index;
+
+    if (term >= (TermId)model->idCapacity) {
+        int idCapacity = model->idCapacity;
+        while ((TermId)idCapacity <= term) idCapacity *= 2;
+        model->indexOfTerm = (int*)realloc(model->indexOfTerm, idCapacity * sizeof(int));
+        memset(model->indexOfTerm + model->idCapacity, 0xFF, (idCapacity - model->idCapacity) * sizeof(int));
+        model->idCapacity = idCapacity;
+    }
+    if (model->termCount == model->capacity) {
+        model->capacity *= 2;
+        model->terms = (TermId*)realloc(model->terms, model->capacity * sizeof(TermId));
+        model->contexts = (float*)realloc(model->contexts, (size_t)model->capacity * EMBEDDING_DIM * sizeof(float));
+    }
+
+    index = model->termCount++;
+    model->terms[index] = term;
+    memset(model->contexts + (size_t)index * EMBEDDING_DIM, 0, EMBEDDING_DIM * sizeof(float));
+    model->indexOfTerm[term] = index;
+    return index;
+}
+
+// Adds every pair within EMBEDDING_WINDOW in both directions, weighted by
+// distance, the same co-occurrences the keyword graph is built from
+void addEmbeddingContext(EmbeddingModel* model, const TermId terms[], int tokenCount) {
+    if (tokenCount == 0) return;
+    int* termIndex = (int*)malloc(tokenCount * sizeof(int));
+    int (*positions)[EMBEDDING_SEEDS] = malloc(tokenCount * sizeof(*positions));
+    float (*signs)[EMBEDDING_SEEDS] = malloc(tokenCount * sizeof(*signs));
+
+    for (int i = 0; i < tokenCount; i++) {
+        termIndex[i] = findOrAddModelTerm(model, terms[i]);
+        indexVector(terms[i], positions[i], signs[i]);
+    }
+
+    for (int i = 0; i < tokenCount; i++) {
+        float* context = model->contexts + (size_t)termIndex[i] * EMBEDDING_DIM;
+        for (int j = i + 1; j <= i + EMBEDDING_WINDOW && j < tokenCount; j++) {
+            if (termIndex[j] == termIndex[i]) continue;
+            float weight = 1.0f / (j - i);
+            float* other = model->contexts + (size_t)termIndex[j] * EMBEDDING_DIM;
+            for (int s = 0; s < EMBEDDING_SEEDS; s++) {
+                context[positions[j][s]] += weight * signs[j][s];
+                other[positions[i][s]] += weight * signs[i][s];
+            }
+        }
+    }
+
+    free(termIndex);
+    free(positions);
+    free(signs);
+}
+
+// Spherical k-means on a sample of rows; centroids stay unit length
+static void trainCentroids(const float* vectors, int count, float* centroids, int listCount) {
+    int sampleCount = listCount * 32 < count ? listCount * 32 : count;
+    int* members = (int*)malloc(listCount * sizeof(int));
+    float* sums = (float*)malloc((size_t)listCount * EMBEDDING_DIM * sizeof(float));
+
+    for (int c = 0; c < listCount; c++) {
+        memcpy(centroids + (size_t)c * EMBEDDING_DIM,
+               vectors + (size_t)((long long)c * count / listCount) * EMBEDDING_DIM, EMBEDDING_DIM * sizeof(float));
+    }
+
+    for (int iteration = 0; iteration < EMBEDDING_KMEANS_ITERATIONS; iteration++) {
+        memset(sums, 0, (size_t)listCount * EMBEDDING_DIM * sizeof(float));
+        memset(members, 0, listCount * sizeof(int));
+        for (int s = 0; s < sampleCount; s++) {
+            const float* row = vectors + (size_t)((long long)s * count / sampleCount) * EMBEDDING_DIM;
+            int best = 0;
+            float bestScore = -2.0f;
+            for (int c = 0; c < listCount; c++) {
+                float score = dotProduct(row, centroids + (size_t)c * EMBEDDING_DIM);
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = c;
+                }
+            }
+            members[best]++;
+            float* sum = sums + (size_t)best * EMBEDDING_DIM;
+            for (int d = 0; d < EMBEDDING_DIM; d++) {
+                sum[d] += row[d];
+            }
+        }
+
+        // An empty list keeps its previous centroid
+        for (int c = 0; c < listCount; c++) {
+            if (members[c] == 0) continue;
+            float* sum = sums + (size_t)c * EMBEDDING_DIM;
+            normalizeVector(sum);
+            memcpy(centroids + (size_t)c * EMBEDDING_DIM, sum, EMBEDDING_DIM * sizeof(float));
+        }
+    }
+
+    free(members);
+    free(sums);
+}
+
+// Offline stage: mean-centred, normalized context vectors, clustered into
+// an inverted file of about sqrt(terms) lists once brute force gets slow
+EmbeddingIndex* buildEmbeddingIndex(const EmbeddingModel* model, EmbeddingStats* stats) {
+    double start = currentTimeMs();
+    int n = model->termCount;
+
+    EmbeddingIndex* index = (EmbeddingIndex*)malloc(sizeof(EmbeddingIndex));
+    index->model = model;
+    index->termCount = n;
+    index->listCount = n >= EMBEDDING_BRUTE_FORCE ? (int)sqrt((double)n) : 1;
+
+    // One aligned block: the row matrix followed by the centroids
+    size_t floats = ((size_t)n + index->listCount) * EMBEDDING_DIM;
+    index->allocation = malloc(floats * sizeof(float) + 15);
+    index->vectors = (float*)(((uintptr_t)index->allocation + 15) & ~(uintptr_t)15);
+    index->centroids = index->vectors + (size_t)n * EMBEDDING_DIM;
+    index->terms = (TermId*)malloc((n > 0 ? n : 1) * sizeof(TermId));
+    index->rowOfTerm = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    index->listStart = (int*)calloc(index->listCount + 1, sizeof(int));
+
+    // Subtracting the mean removes the direction every frequent word shares
+    float* normalized = (float*)malloc(((size_t)n > 0 ? (size_t)n : 1) * EMBEDDING_DIM * sizeof(float) + 15);
+    float* rows = (float*)(((uintptr_t)normalized + 15) & ~(uintptr_t)15);
+    float mean[EMBEDDING_DIM] = {0};
+    for (int t = 0; t < n; t++) {
+        for (int d = 0; d < EMBEDDING_DIM; d++) {
+            mean[d] += model->contexts[(size_t)t * EMBEDDING_DIM + d];
+        }
+    }
+    for (int t = 0; t < n; t++) {
+        float* row = rows + (size_t)t * EMBEDDING_DIM;
+        for (int d = 0; d < EMBEDDING_DIM; d++) {
+            row[d] = model->contexts[(size_t)t * EMBEDDING_DIM + d] - mean[d] / n;
+        }
+        normalizeVector(row);
+    }
+
+    int* list = (int*)calloc(n > 0 ? n : 1, sizeof(int));
+    if (index->listCount > 1) {
+        trainCentroids(rows, n, index->centroids, index->listCount);
+        for (int t = 0; t < n; t++) {
+            float bestScore = -2.0f;
+            for (int c = 0; c < index->listCount; c++) {
+                float score = dotProduct(rows + (size_t)t * EMBEDDING_DIM, index->centroids + (size_t)c * EMBEDDING_DIM);
+                if (score > bestScore) {
+                    bestScore = score;
+                    list[t] = c;
+                }
+            }
+        }
+    }
+
+    // Counting sort of rows by list
+    for (int t = 0; t < n; t++) {
+        index->listStart[list[t] + 1]++;
+    }
+    for (int c = 0; c < index->listCount; c++) {
+        index->listStart[c + 1] += index->listStart[c];
+    }
+    int* fill = (int*)malloc(index->listCount * sizeof(int));
+    memcpy(fill, index->listStart, index->listCount * sizeof(int));
+    for (int t = 0; t < n; t++) {
+        int row = fill[list[t]]++;
+        index->rowOfTerm[t] = row;
+        index->terms[row] = model->terms[t];
+        memcpy(index->vectors + (size_t)row * EMBEDDING_DIM, rows + (size_t)t * EMBEDDING_DIM,
+               EMBEDDING_DIM * sizeof(float));
+    }
+
+    free(fill);
+    free(list);
+    free(normalized);
+
+    stats->terms = n;
+    stats->lists = index->listCount;
+    stats->elapsedMs = currentTimeMs() - start;
+    return index;
+}
+
+// Keeps results sorted by descending score
+static void offerCandidate(int row, float score, int best[], float bestScores[], int* count, int maxResults) {
+    if (*count == maxResults && score <= bestScores[maxResults - 1]) return;
+    int i = *count < maxResults ? (*count)++ : maxResults - 1;
+    while (i > 0 && bestScores[i - 1] < score) {
+        best[i] = best[i - 1];
+        bestScores[i] = bestScores[i - 1];
+        i--;
+    }
+    best[i] = row;
+    bestScores[i] = score;
+}
+
+// Top-k cosine neighbours of keyword, excluding itself. Scans the
+// EMBEDDING_PROBES lists whose centroids are closest to the query.
+int findSimilarKeywords(const EmbeddingIndex* index, TermId keyword, TermId similar[],
+                        float scores[], int maxResults, QueryBudget* budget) {
+    if (maxResults > MAX_SIMILAR) maxResults = MAX_SIMILAR;
+    int term = findModelTerm(index->model, keyword);
+    if (term == -1 || term >= index->termCount || maxResults <= 0) return 0;
+
+    int queryRow = index->rowOfTerm[term];
+    const float* query = index->vectors + (size_t)queryRow * EMBEDDING_DIM;
+
+    int probes[EMBEDDING_PROBES];
+    float probeScores[EMBEDDING_PROBES];
+    int probeCount = 0;
+    if (index->listCount == 1) {
+        probes[probeCount++] = 0;
+    } else {
+        for (int c = 0; c < index->listCount; c++) {
+            offerCandidate(c, dotProduct(query, index->centroids + (size_t)c * EMBEDDING_DIM),
+                           probes, probeScores, &probeCount, EMBEDDING_PROBES);
+        }
+    }
+
+    int best[MAX_SIMILAR];
+    float bestScores[MAX_SIMILAR];
+    int count = 0;
+    // Charged per list, so a truncated query returns the best of the lists
+    // it managed to scan
+    for (int p = 0; p < probeCount; p++) {
+        if (!chargeQueryBudget(budget, index->listStart[probes[p] + 1] - index->listStart[probes[p]])) break;
+        for (int row = index->listStart[probes[p]]; row < index->listStart[probes[p] + 1]; row++) {
+            if (row == queryRow) continue;
+            offerCandidate(row, dotProduct(query, index->vectors + (size_t)row * EMBEDDING_DIM),
+                           best, bestScores, &count, maxResults);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        similar[i] = index->terms[best[i]];
+        scores[i] = bestScores[i];
+    }
+    return count;
+}
+
+void freeEmbeddingIndex(EmbeddingIndex* index) {
+    if (index == NULL) return;
+    free(index->allocation);
+    free(index->terms);
+    free(index->rowOfTerm);
+    free(index->listStart);
+    free(index);
+}
+
+void freeEmbeddingModel(EmbeddingModel* model) {
+    if (model == NULL) return;
+    free(model->terms);
+    free(model->contexts);
+    free(model->indexOfTerm);
+    free(model);
+}
@@ -0,0 +1,57 @@
+#ifndef EMBEDDING_H
+#define EMBEDDING_H
+
+#include "graph.h"
+#include "budget.h"
+#include "dictionary.h"
+
+#define EMBEDDING_DIM 128         // Multiple of 16 for the SIMD kernel
+#define EMBEDDING_SEEDS 8         // Non-zero entries in each random index vector
+#define EMBEDDING_WINDOW 3        // Same co-occurrence window as the graph
+#define EMBEDDING_BRUTE_FORCE 4096  // Below this many terms every vector is scanned
+#define EMBEDDING_PROBES 8        // IVF lists scanned per query
+#define EMBEDDING_KMEANS_ITERATIONS 6
+#define MAX_SIMILAR 10
+
+// Random indexing: every term has a fixed sparse random "index vector", and
+// its context vector is the sum of the index vectors of the terms it
+// co-occurs with. Terms used in similar contexts end up with similar vectors.
+typedef struct {
+    TermId* terms;     // Model index -> term id
+    float* contexts;   // termCount x EMBEDDING_DIM, accumulated at ingest
+    int* indexOfTerm;  // Term id -> model index, -1 when absent
+    int idCapacity;    // Entries in indexOfTerm
+    int termCount;
+    int capacity;
+} EmbeddingModel;
+
+// Normalized vectors in one contiguous, 16-byte aligned matrix. Rows are
+// grouped by inverted-file list so a probe scans memory sequentially.
+typedef struct {
+    float* vectors;    // termCount x EMBEDDING_DIM
+    void* allocation;  // Unaligned block behind vectors
+    TermId* terms;     // Row order
+    int* rowOfTerm;    // Model term index -> row
+    float* centroids;  // listCount x EMBEDDING_DIM
+    int* listStart;    // listCount + 1 row offsets
+    int listCount;
+    int termCount;
+    const EmbeddingModel* model;
+} EmbeddingIndex;
+
+typedef struct {
+    int terms;
+    int lists;
+    double elapsedMs;
+} EmbeddingStats;
+
+// Function declarations
+EmbeddingModel* createEmbeddingModel();
+void addEmbeddingContext(EmbeddingModel* model, const TermId terms[], int tokenCount);
+EmbeddingIndex* buildEmbeddingIndex(const EmbeddingModel* model, EmbeddingStats* stats);
+int findSimilarKeywords(const EmbeddingIndex* index, TermId keyword, TermId similar[],
+                        float scores[], int maxResults, QueryBudget* budget);
+void freeEmbeddingIndex(EmbeddingIndex* index);
+void freeEmbeddingModel(EmbeddingModel* model);
+
+#endif
@@ -0,0 +1,55 @@
+#include <stdio.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#endif
+#include "filelock.h"
+
+// Blocks until the lock is granted. Shared locks may be held by several
+// processes at once; an exclusive one by a single process. Returns 0 if
+// the lock file cannot be opened.
+int acquireFileLock(FileLock* lock, const char* path, int exclusive) {
+    char lockPath[300];
+    snprintf(lockPath, sizeof(lockPath), "%s.lock", path);
+    lock->fd = -1;
+    lock->handle = NULL;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(lockPath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return 0;
+    OVERLAPPED region = {0};
+    if (!LockFileEx(file, exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, 1, 0, &region)) {
+        CloseHandle(file);
+        return 0;
+    }
+    lock->handle = file;
+#else
+    int fd = open(lockPath, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return 0;
+    if (flock(fd, exclusive ? LOCK_EX : LOCK_SH) != 0) {
+        close(fd);
+        return 0;
+    }
+    lock->fd = fd;
+#endif
+    return 1;
+}
+
+void releaseFileLock(FileLock* lock) {
+#ifdef _WIN32
+    if (lock->handle == NULL) return;
+    OVERLAPPED region = {0};
+    UnlockFileEx((HANDLE)lock->handle, 0, 1, 0, &region);
+    CloseHandle((HANDLE)lock->handle);
+    lock->handle = NULL;
+#else
+    if (lock->fd < 0) return;
+    flock(lock->fd, LOCK_UN);
+    close(lock->fd);
+    lock->fd = -1;
+#endif
+}
@@ -0,0 +1,17 @@
+#ifndef FILELOCK_H
+#define FILELOCK_H
+
+// Advisory lock on "<path>.lock". Every engine process sharing the index
+// files takes it around writes, so a record being appended by one process
+// is never seen half-written by another. The lock file itself is never
+// renamed, so it stays valid while the file it guards is replaced.
+typedef struct {
+    int fd;          // POSIX descriptor
+    void* handle;    // Windows handle
+} FileLock;
+
+// Function declarations
+int acquireFileLock(FileLock* lock, const char* path, int exclusive);
+void releaseFileLock(FileLock* lock);
+
+#endif
@@ -3,81 +3,169 @@
 #include <string.h>
 #include <ctype.h>
 #include "graph.h"
+#include "timer.h"
 
 Graph* createGraph() {
     Graph* graph = (Graph*)malloc(sizeof(Graph));
+    graph->nodes = NULL;
     graph->nodeCount = 0;
+    graph->capacity = 0;
+    graph->componentCount = 0;
     return graph;
 }
 
-int findOrAddNode(Graph* graph, const char* keyword) {
-    // Check if node already exists
-    for (int i = 0; i < graph->nodeCount; i++) {
-        if (strcasecmp(graph->nodes[i].keyword, keyword) == 0) {
-            return i; // Return existing index
-        }
+// Makes node id exist; nodes in between start out without edges
+static void ensureNode(Graph* graph, TermId id) {
+    if ((int)id < graph->nodeCount) return;
+    if ((int)id >= graph->capacity) {
+        int capacity = graph->capacity == 0 ? 1024 : graph->capacity;
+        while (capacity <= (int)id) capacity *= 2;
+        graph->nodes = (GraphNode*)realloc(graph->nodes, capacity * sizeof(GraphNode));
+        graph->capacity = capacity;
     }
-    
-    // Add new node
-    if (graph->nodeCount < MAX_KEYWORDS) {
-        strcpy(graph->nodes[graph->nodeCount].keyword, keyword);
-        graph->nodes[graph->nodeCount].relatedCount = 0;
-        graph->nodes[graph->nodeCount].visited = 0;
-        graph->nodes[graph->nodeCount].parent = -1;  // Initialize parent
-        graph->nodeCount++;
-        return graph->nodeCount - 1;
+    for (int i = graph->nodeCount; i <= (int)id; i++) {
+        graph->nodes[i].relatedCount = 0;
+        graph->nodes[i].visited = 0;
+        graph->nodes[i].parent = -1;  // Initialize parent
+        graph->nodes[i].rank = 0.0f;
+        graph->nodes[i].component = i;
+        graph->nodes[i].componentSize = 1;
     }
-    return -1; // Graph full
+    graph->componentCount += (int)id + 1 - graph->nodeCount;
+    graph->nodeCount = (int)id + 1;
 }
 
-void addEdge(Graph* graph, const char* keyword1, const char* keyword2) {
-    int index1 = findOrAddNode(graph, keyword1);
-    int index2 = findOrAddNode(graph, keyword2);
-    
-    if (index1 == -1 || index2 == -1 || index1 == index2) return;
+// Root of node's component, halving the path on the way up
+static int findComponent(Graph* graph, int node) {
+    while (graph->nodes[node].component != node) {
+        int grandparent = graph->nodes[graph->nodes[node].component].component;
+        graph->nodes[node].component = grandparent;
+        node = grandparent;
+    }
+    return node;
+}
+
+// Union by size, so trees stay logarithmically shallow between labelings
+static void joinComponents(Graph* graph, int node1, int node2) {
+    int root1 = findComponent(graph, node1);
+    int root2 = findComponent(graph, node2);
+    if (root1 == root2) return;
+    if (graph->nodes[root1].componentSize < graph->nodes[root2].componentSize) {
+        int swap = root1;
+        root1 = root2;
+        root2 = swap;
+    }
+    graph->nodes[root2].component = root1;
+    graph->nodes[root1].componentSize += graph->nodes[root2].componentSize;
+    graph->componentCount--;
+}
+
+void addEdge(Graph* graph, TermId keyword1, TermId keyword2) {
+    if (keyword1 == keyword2) return;
+    ensureNode(graph, keyword1 > keyword2 ? keyword1 : keyword2);
+    GraphNode* node1 = &graph->nodes[keyword1];
+    GraphNode* node2 = &graph->nodes[keyword2];
     
     // Check if edge already exists from keyword1 to keyword2
-    for (int i = 0; i < graph->nodes[index1].relatedCount; i++) {
-        if (graph->nodes[index1].related[i] == index2) return;
+    for (int i = 0; i < node1->relatedCount; i++) {
+        if (node1->related[i] == keyword2) return;
     }
     
     // Add edge in both directions (undirected graph)
-    if (graph->nodes[index1].relatedCount < MAX_RELATED) {
-        graph->nodes[index1].related[graph->nodes[index1].relatedCount++] = index2;
+    int added = 0;
+    if (node1->relatedCount < MAX_RELATED) {
+        node1->related[node1->relatedCount++] = keyword2;
+        added = 1;
     }
     
-    if (graph->nodes[index2].relatedCount < MAX_RELATED) {
-        graph->nodes[index2].related[graph->nodes[index2].relatedCount++] = index1;
+    if (node2->relatedCount < MAX_RELATED) {
+        node2->related[node2->relatedCount++] = keyword1;
+        added = 1;
     }
+    
+    // A full list keeps only one direction, so components over-approximate
+    // reachability: different components always means no path
+    if (added) joinComponents(graph, keyword1, keyword2);
 }
 
-void BFS(Graph* graph, int startIndex, char related[][MAX_WORD_LENGTH], int* count) {
-    if (startIndex == -1) return;
+// Points every node straight at its root so component lookups during
+// queries are a single read. Components are maintained by addEdge(), so
+// this is one linear pass after ingest, not a traversal.
+void labelComponents(Graph* graph, ComponentStats* stats) {
+    double start = currentTimeMs();
+    stats->components = 0;
+    stats->largest = 0;
+    stats->isolated = 0;
     
-    // Reset visited flags
     for (int i = 0; i < graph->nodeCount; i++) {
-        graph->nodes[i].visited = 0;
+        int root = findComponent(graph, i);
+        graph->nodes[i].component = root;
+        if (root != i) continue;
+        int size = graph->nodes[i].componentSize;
+        if (size == 1) {
+            stats->isolated++;
+        } else {
+            stats->components++;
+            if (size > stats->largest) stats->largest = size;
+        }
     }
+    stats->elapsedMs = currentTimeMs() - start;
+}
+
+// 0 for keywords not in the graph; 1 means there may be a path
+int sameComponent(Graph* graph, TermId keyword1, TermId keyword2) {
+    if (keyword1 == NO_TERM || keyword2 == NO_TERM ||
+        (int)keyword1 >= graph->nodeCount || (int)keyword2 >= graph->nodeCount) {
+        return 0;
+    }
+    return findComponent(graph, (int)keyword1) == findComponent(graph, (int)keyword2);
+}
+
+// 0 for keywords not in the graph
+int componentSizeOf(Graph* graph, TermId keyword) {
+    if (keyword == NO_TERM || (int)keyword >= graph->nodeCount) return 0;
+    return graph->nodes[findComponent(graph, (int)keyword)].componentSize;
+}
+
+// Every node a search marks is in its queue; clearing just those keeps the
+// cost proportional to what was explored rather than to the whole graph
+static void clearSearch(Graph* graph, const int* queue, int queued) {
+    for (int i = 0; i < queued; i++) {
+        graph->nodes[queue[i]].visited = 0;
+        graph->nodes[queue[i]].parent = -1;
+    }
+}
+
+// Stops early when the budget runs out; the candidates found so far are
+// still ranked and returned
+void BFS(Graph* graph, int startIndex, TermId related[], int* count, QueryBudget* budget) {
+    *count = 0;
+    if (startIndex == -1) return;
+    
+    // The search never leaves the component, so it bounds the queue, and a
+    // node without edges has nothing to find
+    int componentSize = componentSizeOf(graph, (TermId)startIndex);
+    if (componentSize <= 1) return;
     
-    int queue[MAX_KEYWORDS];
+    int* queue = (int*)malloc(componentSize * sizeof(int));
     int front = 0, rear = 0;
+    int candidates[RELATED_CANDIDATES];
+    int candidateCount = 0;
     
     // BFS initialization
     graph->nodes[startIndex].visited = 1;
     queue[rear++] = startIndex;
-    *count = 0;
     
-    while (front < rear && *count < MAX_RELATED) {
+    while (front < rear && candidateCount < RELATED_CANDIDATES && chargeQueryBudget(budget, 1)) {
         int current = queue[front++];
         
-        // Add related nodes (excluding the start node itself)
+        // Collect related nodes (excluding the start node itself)
         if (current != startIndex) {
-            strcpy(related[*count], graph->nodes[current].keyword);
-            (*count)++;
+            candidates[candidateCount++] = current;
         }
         
         // Enqueue all unvisited neighbors
-        for (int i = 0; i < graph->nodes[current].relatedCount && *count < MAX_RELATED; i++) {
+        for (int i = 0; i < graph->nodes[current].relatedCount; i++) {
             int neighbor = graph->nodes[current].related[i];
             if (!graph->nodes[neighbor].visited) {
                 graph->nodes[neighbor].visited = 1;
@@ -85,67 +173,70 @@ void BFS(Graph* graph, int startIndex, char related[][MAX_WORD_LENGTH], int* cou
             }
         }
     }
-}
-
-void findRelatedKeywords(Graph* graph, const char* keyword, char related[][MAX_WORD_LENGTH], int* count) {
-    int index = -1;
-    for (int i = 0; i < graph->nodeCount; i++) {
-        if (strcasecmp(graph->nodes[i].keyword, keyword) == 0) {
-            index = i;
-            break;
+    
+    // Order candidates by keyword rank; insertion sort keeps BFS order on ties
+    for (int i = 1; i < candidateCount; i++) {
+        int node = candidates[i];
+        int j = i - 1;
+        while (j >= 0 && graph->nodes[candidates[j]].rank < graph->nodes[node].rank) {
+            candidates[j + 1] = candidates[j];
+            j--;
         }
+        candidates[j + 1] = node;
+    }
+    
+    for (int i = 0; i < candidateCount && *count < MAX_RELATED; i++) {
+        related[(*count)++] = (TermId)candidates[i];
     }
     
-    if (index != -1) {
-        BFS(graph, index, related, count);
+    clearSearch(graph, queue, rear);
+    free(queue);
+}
+
+void findRelatedKeywords(Graph* graph, TermId keyword, TermId related[], int* count, QueryBudget* budget) {
+    if (keyword != NO_TERM && (int)keyword < graph->nodeCount) {
+        BFS(graph, (int)keyword, related, count, budget);
     } else {
         *count = 0;
     }
 }
 
 // NEW: Find path between two keywords using BFS with stack-based reconstruction
-int findPathBetweenKeywords(Graph* graph, const char* startKeyword, const char* endKeyword, 
-                            char path[][MAX_WORD_LENGTH], int* pathLength) {
+int findPathBetweenKeywords(Graph* graph, TermId startKeyword, TermId endKeyword,
+                            TermId path[], int* pathLength, QueryBudget* budget) {
     *pathLength = 0;
     
-    // Find start and end node indices
-    int startIndex = -1, endIndex = -1;
-    for (int i = 0; i < graph->nodeCount; i++) {
-        if (strcasecmp(graph->nodes[i].keyword, startKeyword) == 0) {
-            startIndex = i;
-        }
-        if (strcasecmp(graph->nodes[i].keyword, endKeyword) == 0) {
-            endIndex = i;
-        }
-    }
-    
     // Check if both keywords exist
-    if (startIndex == -1 || endIndex == -1) {
+    if (startKeyword == NO_TERM || endKeyword == NO_TERM ||
+        (int)startKeyword >= graph->nodeCount || (int)endKeyword >= graph->nodeCount) {
         return 0; // Keywords not found
     }
+    int startIndex = (int)startKeyword, endIndex = (int)endKeyword;
     
     // Same keyword
     if (startIndex == endIndex) {
-        strcpy(path[0], startKeyword);
+        path[0] = startKeyword;
         *pathLength = 1;
         return 1;
     }
     
-    // Reset visited flags and parents
-    for (int i = 0; i < graph->nodeCount; i++) {
-        graph->nodes[i].visited = 0;
-        graph->nodes[i].parent = -1;
+    // Keywords in different components have no path; answer without
+    // searching or charging the budget
+    if (!sameComponent(graph, startKeyword, endKeyword)) {
+        return 0;
     }
     
     // BFS to find shortest path
-    int queue[MAX_KEYWORDS];
+    int* queue = (int*)malloc(componentSizeOf(graph, startKeyword) * sizeof(int));
     int front = 0, rear = 0;
     
     graph->nodes[startIndex].visited = 1;
     queue[rear++] = startIndex;
     
     int found = 0;
-    while (front < rear && !found) {
+    // A search cut short by the budget reports no path; the caller tells
+    // the two cases apart through budget->truncated
+    while (front < rear && !found && chargeQueryBudget(budget, 1)) {
         int current = queue[front++];
         
         // Check if we reached the destination
@@ -167,6 +258,8 @@ int findPathBetweenKeywords(Graph* graph, const char* startKeyword, const char*
     
     // If no path found
     if (!found) {
+        clearSearch(graph, queue, rear);
+        free(queue);
         return 0;
     }
     
@@ -183,12 +276,94 @@ int findPathBetweenKeywords(Graph* graph, const char* startKeyword, const char*
     // Reverse the path (stack behavior - LIFO)
     *pathLength = tempLength;
     for (int i = 0; i < tempLength; i++) {
-        strcpy(path[i], graph->nodes[tempPath[tempLength - 1 - i]].keyword);
+        path[i] = (TermId)tempPath[tempLength - 1 - i];
     }
     
+    clearSearch(graph, queue, rear);
+    free(queue);
+    
     return 1; // Path found
 }
 
+// Gathers the keyword and its graph neighbourhood for query expansion,
+// nearest first: a keyword h hops away weighs EXPAND_DECAY^h. When a hop
+// level does not fit in maxTerms, its highest-ranked keywords are kept.
+// Returns the number of terms, the keyword itself first.
+int expandKeyword(Graph* graph, TermId keyword, int maxHops, float minWeight,
+                  TermId terms[], float weights[], int maxTerms, QueryBudget* budget) {
+    if (keyword == NO_TERM || maxTerms < 1) return 0;
+    int count = 0;
+    terms[count] = keyword;
+    weights[count++] = 1.0f;
+    
+    // As in BFS(), the component bounds the queue and a keyword without
+    // edges has no neighbourhood
+    int componentSize = componentSizeOf(graph, keyword);
+    if (componentSize <= 1) return count;
+    
+    int startIndex = (int)keyword;
+    int* queue = (int*)malloc(componentSize * sizeof(int));
+    int rear = 0;
+    graph->nodes[startIndex].visited = 1;
+    queue[rear++] = startIndex;
+    
+    int levelStart = 0, levelEnd = rear;
+    float weight = 1.0f;
+    for (int hop = 1; hop <= maxHops && count < maxTerms; hop++) {
+        weight *= EXPAND_DECAY;
+        if (weight < minWeight) break;
+        
+        // The next level is queue[levelEnd..rear)
+        int complete = 1;
+        for (int i = levelStart; i < levelEnd; i++) {
+            if (!chargeQueryBudget(budget, 1)) {
+                complete = 0;
+                break;
+            }
+            GraphNode* node = &graph->nodes[queue[i]];
+            for (int r = 0; r < node->relatedCount; r++) {
+                int neighbor = node->related[r];
+                if (!graph->nodes[neighbor].visited) {
+                    graph->nodes[neighbor].visited = 1;
+                    queue[rear++] = neighbor;
+                }
+            }
+        }
+        
+        // Select the best-ranked keywords of the level that still fit
+        int take = rear - levelEnd < maxTerms - count ? rear - levelEnd : maxTerms - count;
+        for (int i = levelEnd; i < levelEnd + take; i++) {
+            int best = i;
+            for (int j = i + 1; j < rear; j++) {
+                if (graph->nodes[queue[j]].rank > graph->nodes[queue[best]].rank) best = j;
+            }
+            int swap = queue[i];
+            queue[i] = queue[best];
+            queue[best] = swap;
+            terms[count] = (TermId)queue[i];
+            weights[count++] = weight;
+        }
+        
+        // Once the whole component is queued no later hop finds anything
+        if (!complete || rear == componentSize) break;
+        levelStart = levelEnd;
+        levelEnd = rear;
+    }
+    
+    clearSearch(graph, queue, rear);
+    free(queue);
+    return count;
+}
+
+int countGraphEdges(Graph* graph) {
+    int total = 0;
+    for (int i = 0; i < graph->nodeCount; i++) {
+        total += graph->nodes[i].relatedCount;
+    }
+    return total / 2;
+}
+
 void freeGraph(Graph* graph) {
+    free(graph->nodes);
     free(graph);
 }
\ No newline at end of file
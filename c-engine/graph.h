@@ -1,33 +1,56 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
-#define MAX_KEYWORDS 1000
+#include "budget.h"
+#include "dictionary.h"
+
 #define MAX_RELATED 20
-#define MAX_WORD_LENGTH 50
 #define MAX_PATH_LENGTH 10  // New: Maximum path length for tracing
+#define RELATED_CANDIDATES 100  // BFS candidates considered before ranking
+#define EXPAND_MAX_HOPS 2       // Default graph distance for query expansion
+#define EXPAND_DECAY 0.5f       // Weight kept per hop away from the query keyword
+#define EXPAND_MIN_WEIGHT 0.2f  // Default: keywords weighted below this are not added
+#define EXPAND_MAX_TERMS 32     // Query keyword included
 
+// Node i is the keyword with term id i
 typedef struct GraphNode {
-    char keyword[MAX_WORD_LENGTH];
-    int related[MAX_RELATED];
+    TermId related[MAX_RELATED];
     int relatedCount;
     int visited;
     int parent;  // New: For path reconstruction
+    float rank;  // Keyword importance from the PageRank pass (rank.c)
+    int component;      // Union-find parent; the component root after labelComponents()
+    int componentSize;  // Nodes in the component, valid at roots
 } GraphNode;
 
 typedef struct {
-    GraphNode nodes[MAX_KEYWORDS];
+    GraphNode* nodes;  // Grown by doubling to cover every term id with an edge
     int nodeCount;
+    int capacity;
+    int componentCount;  // Including single nodes without edges
 } Graph;
 
+typedef struct {
+    int components;  // With at least one edge
+    int largest;
+    int isolated;    // Nodes without edges
+    double elapsedMs;
+} ComponentStats;
+
 // Existing function declarations
 Graph* createGraph();
-int findOrAddNode(Graph* graph, const char* keyword);
-void addEdge(Graph* graph, const char* keyword1, const char* keyword2);
-void findRelatedKeywords(Graph* graph, const char* keyword, char related[][MAX_WORD_LENGTH], int* count);
+void addEdge(Graph* graph, TermId keyword1, TermId keyword2);
+void findRelatedKeywords(Graph* graph, TermId keyword, TermId related[], int* count, QueryBudget* budget);
+int countGraphEdges(Graph* graph);
+void labelComponents(Graph* graph, ComponentStats* stats);
+int sameComponent(Graph* graph, TermId keyword1, TermId keyword2);
+int componentSizeOf(Graph* graph, TermId keyword);
 void freeGraph(Graph* graph);
 
 // New: Path tracing function declaration
-int findPathBetweenKeywords(Graph* graph, const char* startKeyword, const char* endKeyword, 
-                            char path[][MAX_WORD_LENGTH], int* pathLength);
+int findPathBetweenKeywords(Graph* graph, TermId startKeyword, TermId endKeyword,
+                            TermId path[], int* pathLength, QueryBudget* budget);
+int expandKeyword(Graph* graph, TermId keyword, int maxHops, float minWeight,
+                  TermId terms[], float weights[], int maxTerms, QueryBudget* budget);
 
 #endif
\ No newline at end of file
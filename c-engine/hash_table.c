@@ -4,12 +4,30 @@
 #include <ctype.h>
 #include "hash_table.h"
 
-unsigned int hashFunction(const char* str) {
-    unsigned int hash = 0;
-    for (int i = 0; str[i] != '\0'; i++) {
-        hash = hash * 31 + tolower(str[i]);
+// Term ids are dense, so a multiplicative mix spreads neighbours apart
+unsigned int hashFunction(TermId term) {
+    return (term * 2654435761u) % HASH_SIZE;
+}
+
+// Records one occurrence position; offset -1 means the position is unknown
+static void addOffset(Document* doc, int offset) {
+    if (offset < 0) return;
+    
+    // Capacity starts at 4 and doubles whenever the count hits a power of two
+    if (doc->offsetCount == 0) {
+        doc->offsets = (int*)malloc(4 * sizeof(int));
+    } else if (doc->offsetCount >= 4 && (doc->offsetCount & (doc->offsetCount - 1)) == 0) {
+        doc->offsets = (int*)realloc(doc->offsets, doc->offsetCount * 2 * sizeof(int));
     }
-    return hash % HASH_SIZE;
+    doc->offsets[doc->offsetCount++] = offset;
+}
+
+static void initDocument(Document* doc, int docId, int frequency, int offset) {
+    doc->docId = docId;
+    doc->frequency = frequency;
+    doc->offsets = NULL;
+    doc->offsetCount = 0;
+    addOffset(doc, offset);
 }
 
 HashTable* createHashTable() {
@@ -20,24 +38,24 @@ HashTable* createHashTable() {
     return ht;
 }
 
-void insertHashTable(HashTable* ht, const char* keyword, const char* filename, int frequency) {
-    unsigned int index = hashFunction(keyword);
+void insertHashTable(HashTable* ht, TermId term, int docId, int frequency, int offset) {
+    unsigned int index = hashFunction(term);
     
     // Check if keyword already exists
     HashEntry* current = ht->table[index];
     while (current != NULL) {
-        if (strcasecmp(current->keyword, keyword) == 0) {
+        if (current->term == term) {
             // Keyword exists, update document frequency
             for (int i = 0; i < current->docCount; i++) {
-                if (strcmp(current->documents[i].filename, filename) == 0) {
+                if (current->documents[i].docId == docId) {
                     current->documents[i].frequency += frequency;
+                    addOffset(&current->documents[i], offset);
                     return;
                 }
             }
             // Add new document
             if (current->docCount < MAX_DOCUMENTS) {
-                strcpy(current->documents[current->docCount].filename, filename);
-                current->documents[current->docCount].frequency = frequency;
+                initDocument(&current->documents[current->docCount], docId, frequency, offset);
                 current->docCount++;
             }
             return;
@@ -47,20 +65,19 @@ void insertHashTable(HashTable* ht, const char* keyword, const char* filename, i
     
     // Create new entry
     HashEntry* newEntry = (HashEntry*)malloc(sizeof(HashEntry));
-    strcpy(newEntry->keyword, keyword);
-    strcpy(newEntry->documents[0].filename, filename);
-    newEntry->documents[0].frequency = frequency;
+    newEntry->term = term;
+    initDocument(&newEntry->documents[0], docId, frequency, offset);
     newEntry->docCount = 1;
     newEntry->next = ht->table[index];
     ht->table[index] = newEntry;
 }
 
-HashEntry* searchHashTable(HashTable* ht, const char* keyword) {
-    unsigned int index = hashFunction(keyword);
+HashEntry* searchHashTable(HashTable* ht, TermId term) {
+    unsigned int index = hashFunction(term);
     HashEntry* current = ht->table[index];
     
     while (current != NULL) {
-        if (strcasecmp(current->keyword, keyword) == 0) {
+        if (current->term == term) {
             return current;
         }
         current = current->next;
@@ -68,14 +85,34 @@ HashEntry* searchHashTable(HashTable* ht, const char* keyword) {
     return NULL;
 }
 
-void freeHashTable(HashTable* ht) {
+void getHashTableStats(HashTable* ht, int* termCount, int* postingCount) {
+    *termCount = 0;
+    *postingCount = 0;
+    for (int i = 0; i < HASH_SIZE; i++) {
+        for (HashEntry* current = ht->table[i]; current != NULL; current = current->next) {
+            (*termCount)++;
+            *postingCount += current->docCount;
+        }
+    }
+}
+
+// Frees every entry but keeps the table itself for reuse
+void clearHashTable(HashTable* ht) {
     for (int i = 0; i < HASH_SIZE; i++) {
         HashEntry* current = ht->table[i];
         while (current != NULL) {
             HashEntry* temp = current;
             current = current->next;
+            for (int d = 0; d < temp->docCount; d++) {
+                free(temp->documents[d].offsets);
+            }
             free(temp);
         }
+        ht->table[i] = NULL;
     }
+}
+
+void freeHashTable(HashTable* ht) {
+    clearHashTable(ht);
     free(ht);
 }
\ No newline at end of file
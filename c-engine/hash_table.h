@@ -1,17 +1,20 @@
 #ifndef HASH_TABLE_H
 #define HASH_TABLE_H
 
+#include "dictionary.h"
+
 #define HASH_SIZE 1000
 #define MAX_DOCUMENTS 100
-#define MAX_KEYWORD_LENGTH 50
 
 typedef struct Document {
-    char filename[100];
+    int docId;  // Index into the segment index document table
     int frequency;
+    int* offsets;     // Byte offset of each occurrence, grown by doubling
+    int offsetCount;
 } Document;
 
 typedef struct HashEntry {
-    char keyword[MAX_KEYWORD_LENGTH];
+    TermId term;
     Document documents[MAX_DOCUMENTS];
     int docCount;
     struct HashEntry* next;
@@ -22,10 +25,12 @@ typedef struct {
 } HashTable;
 
 // Function declarations
-unsigned int hashFunction(const char* str);
+unsigned int hashFunction(TermId term);
 HashTable* createHashTable();
-void insertHashTable(HashTable* ht, const char* keyword, const char* filename, int frequency);
-HashEntry* searchHashTable(HashTable* ht, const char* keyword);
+void insertHashTable(HashTable* ht, TermId term, int docId, int frequency, int offset);
+HashEntry* searchHashTable(HashTable* ht, TermId term);
+void getHashTableStats(HashTable* ht, int* termCount, int* postingCount);
+void clearHashTable(HashTable* ht);
 void freeHashTable(HashTable* ht);
 
 #endif
\ No newline at end of file
@@ -2,7 +2,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
-#include <dirent.h>
 #include <sys/stat.h>
 #include "trie.h"
 #include "hash_table.h"
@@ -10,97 +9,559 @@
 #include "queue.h"
 #include "stack.h"
 #include "tokenizer.h"
+#include "analyzer.h"
+#include "rank.h"
+#include "segment.h"
+#include "wal.h"
+#include "docstore.h"
+#include "embedding.h"
+#include "crawler.h"
+#include "budget.h"
+#include "sketch.h"
+#include "dedup.h"
+#include "dictionary.h"
+#include "timer.h"
 
 // Global data structures
+TermDictionary* dictionary;  // Term ids shared by every structure below
 TrieNode* trie;
-HashTable* hashTable;
+SegmentIndex* segmentIndex;
 Graph* graph;
 Queue* searchHistory;
 Stack* undoStack;
 Stack* redoStack;
-
-// Windows-compatible function to check if a file is regular file
-int isRegularFile(const char* path) {
-    struct stat path_stat;
-    if (stat(path, &path_stat) != 0) {
-        return 0;
-    }
-    return S_ISREG(path_stat.st_mode);
-}
+Analyzer analyzer;  // Same chain is applied at ingest and at query time
+int rankThreads = RANK_THREADS;
+WriteAheadLog* wal = NULL;  // Every indexed document is logged here first
+DocumentStore* docStore = NULL;  // Document texts for snippets
+int compressStore = 0;
+EmbeddingModel* embeddingModel;  // Context vectors accumulated at ingest
+EmbeddingIndex* embeddingIndex = NULL;  // Rebuilt by embedKeywords()
+int analysisStale = 0;  // Documents were indexed since the last analyzeKeywords()
+CrawlerOptions crawlerOptions;  // Which files processAllDocuments picks up
+double queryDeadlineMs = QUERY_DEADLINE_MS;  // Applied to every query
+long queryWorkBudget = QUERY_WORK_BUDGET;
+FrequencySketch* termSketch;  // Heavy hitters over every ingested token
+FrequencySketch* pairSketch;  // ... and over co-occurring pairs
+DuplicateIndex* duplicateIndex;  // MinHash signatures, for collapsing near-duplicates
+double dedupThreshold = DEDUP_THRESHOLD;
 
 void initializeSystem() {
     printf("Initializing Knowledge Graph Search System...\n");
     fflush(stdout);
+    dictionary = createTermDictionary();
     trie = createTrieNode();
-    hashTable = createHashTable();
+    segmentIndex = createSegmentIndex();
     graph = createGraph();
     searchHistory = createQueue();
     undoStack = createStack();
     redoStack = createStack();
+    initAnalyzer(&analyzer);
+    embeddingModel = createEmbeddingModel();
+    initCrawlerOptions(&crawlerOptions);
+    termSketch = createFrequencySketch();
+    pairSketch = createFrequencySketch();
+    duplicateIndex = createDuplicateIndex();
     printf("System initialized successfully!\n");
     fflush(stdout);
 }
 
-void processDocument(const char* filename) {
-    char tokens[1000][MAX_WORD_LENGTH];
+// Documents given by bare name live in the documents folder
+void resolveDocumentPath(const char* name, char* path, int size) {
+    if (strchr(name, '/') != NULL || strchr(name, '\\') != NULL) {
+        snprintf(path, size, "%s", name);
+    } else {
+        snprintf(path, size, "../documents/%s", name);
+    }
+}
+
+int isLiveDocument(int docId, void* context) {
+    (void)context;
+    return isDocumentLive(segmentIndex, docId);
+}
+
+// Called once docId has been replaced or deleted. A collapsed copy just
+// leaves its cluster. An original takes its live copies down with it, as
+// they have no postings of their own; they stay linked to it so
+// releaseDuplicates() can index them again.
+void retireDocument(int docId) {
+    if (getOriginal(duplicateIndex, docId) != -1) {
+        forgetDuplicate(duplicateIndex, docId);
+        return;
+    }
+    for (int copy = firstCopy(duplicateIndex, docId); copy != -1; copy = nextCopy(duplicateIndex, copy)) {
+        if (getOriginal(duplicateIndex, copy) == docId && isDocumentLive(segmentIndex, copy)) {
+            deleteDocument(segmentIndex, segmentIndex->docs[copy].path);
+        }
+    }
+}
+
+// Feeds a document's terms, and the pairs co-occurring within the graph's
+// window, to the heavy-hitter sketches
+void countTokens(char tokens[][MAX_WORD_LENGTH], int tokenCount) {
+    for (int i = 0; i < tokenCount; i++) {
+        addToSketch(termSketch, tokens[i], 1);
+        for (int j = i + 1; j < i + 4 && j < tokenCount; j++) {
+            if (strcmp(tokens[i], tokens[j]) != 0) {
+                char pair[SKETCH_KEY_LENGTH];
+                formatPairKey(tokens[i], tokens[j], pair);
+                addToSketch(pairSketch, pair, 1);
+            }
+        }
+    }
+}
+
+// Adds one analyzed document to the live index. Shared by fresh ingest
+// and write-ahead log replay, so both make the same duplicate decisions.
+void indexTokens(const char* filename, long mtime, long size, const StoredDocument* stored,
+                 char tokens[][MAX_WORD_LENGTH], const int offsets[], int tokenCount) {
+    // A re-processed file gets a new docId and its old version is tombstoned
+    int previous = findLiveDocument(segmentIndex, filename);
+    int docId = registerDocument(segmentIndex, filename, mtime, size, stored);
+    if (previous != -1) retireDocument(previous);
+    
+    // Each token is looked up once; everything below works on term ids
+    TermId terms[MAX_TOKENS];
+    for (int i = 0; i < tokenCount; i++) {
+        terms[i] = internTerm(dictionary, tokens[i]);
+    }
+    
+    // A near-duplicate joins the cluster of the document it copies instead
+    // of adding its postings, graph edges and counts a second time
+    if (dedupThreshold > 0 && tokenCount >= DEDUP_MIN_TOKENS) {
+        MinHashSignature signature;
+        computeMinHash(terms, tokenCount, &signature);
+        int original = findNearDuplicate(duplicateIndex, &signature, dedupThreshold, isLiveDocument, NULL, NULL);
+        if (original != -1) {
+            addDuplicate(duplicateIndex, docId, original, &signature);
+            return;
+        }
+        addOriginal(duplicateIndex, docId, &signature);
+    }
+    
+    // Add tokens to Trie and build co-occurrence graph
+    for (int i = 0; i < tokenCount; i++) {
+        // Insert into Trie; only a term's first occurrence has to be spelled out
+        if (countTermOccurrence(dictionary, terms[i]) == 1) {
+            insertTrie(trie, tokens[i], terms[i]);
+        }
+        
+        // Insert into the memtable of the segment index, with the byte
+        // offset snippets are cut around
+        addPosting(segmentIndex, terms[i], docId, offsets[i]);
+        
+        // Build graph edges for co-occurring words (within window of 3)
+        for (int j = i + 1; j < i + 4 && j < tokenCount; j++) {
+            addEdge(graph, terms[i], terms[j]);
+        }
+    }
+    countTokens(tokens, tokenCount);
+    addEmbeddingContext(embeddingModel, terms, tokenCount);
+    finishDocument(segmentIndex);
+}
+
+void replayDelete(const char* filename) {
+    int docId = findLiveDocument(segmentIndex, filename);
+    if (deleteDocument(segmentIndex, filename)) {
+        retireDocument(docId);
+        return;
+    }
+    
+    // A copy dropped with its original by an append-only ingest or delete
+    // is still waiting for releaseOrphanedCopies(); deleted, it stays gone
+    for (int i = 0; i < segmentIndex->docCount; i++) {
+        if (getOriginal(duplicateIndex, i) != -1 && strcmp(segmentIndex->docs[i].path, filename) == 0) {
+            forgetDuplicate(duplicateIndex, i);
+        }
+    }
+}
+
+int indexDocumentText(const char* filename, long mtime, long size, const char* text, long length);
+
+// Re-ingests from the document store the copies retireDocument() dropped
+// with original. Each is logged again, so replay finds it indexed on its
+// own after the record that retired original. Returns the number released.
+int releaseDuplicates(int original) {
+    int released = 0;
+    for (int copy = firstCopy(duplicateIndex, original); copy != -1; copy = nextCopy(duplicateIndex, copy)) {
+        if (getOriginal(duplicateIndex, copy) != original || isDocumentLive(segmentIndex, copy)) continue;
+        forgetDuplicate(duplicateIndex, copy);
+        // A newer version of the copy was indexed after original went
+        if (docStore == NULL || findLiveDocument(segmentIndex, segmentIndex->docs[copy].path) != -1) continue;
+        
+        DocInfo info = segmentIndex->docs[copy];
+        char* owned = NULL;
+        const char* stored = loadDocument(docStore, &info.stored, &owned);
+        if (stored == NULL) continue;
+        char* path = strdup(info.path);
+        char* text = owned != NULL ? owned : (char*)malloc(info.stored.rawLength + 1);
+        if (owned == NULL) {
+            memcpy(text, stored, info.stored.rawLength);
+            text[info.stored.rawLength] = '\0';
+        }
+        if (indexDocumentText(path, info.mtime, info.size, text, info.stored.rawLength) >= 0) released++;
+        free(text);
+        free(path);
+    }
+    return released;
+}
+
+// The append-only ingest and delete commands retire originals without an
+// index to find their copies in, so nothing logged the copies again. Replay
+// drops them along with the original; release them once the log is open.
+int releaseOrphanedCopies(int replayedDocs) {
+    int released = 0;
+    for (int docId = 0; docId < replayedDocs; docId++) {
+        if (isDocumentLive(segmentIndex, docId) || getOriginal(duplicateIndex, docId) != -1) continue;
+        if (firstCopy(duplicateIndex, docId) != -1) released += releaseDuplicates(docId);
+    }
+    return released;
+}
+
+// Tokenizes, stores, logs and indexes text already read from filename.
+// Returns the number of tokens indexed, 0 for a near-duplicate collapsed
+// into an indexed document, or -1 on error.
+int indexDocumentText(const char* filename, long mtime, long size, const char* text, long length) {
+    char tokens[MAX_TOKENS][MAX_WORD_LENGTH];
+    int offsets[MAX_TOKENS];
     int tokenCount = 0;
     
     printf("Processing document: %s\n", filename);
     fflush(stdout);
     
-    if (tokenizeFile(filename, tokens, &tokenCount)) {
-        // Add tokens to Trie and build co-occurrence graph
-        for (int i = 0; i < tokenCount; i++) {
-            // Insert into Trie
-            insertTrie(trie, tokens[i]);
-            
-            // Insert into Hash Table
-            insertHashTable(hashTable, tokens[i], filename, 1);
-            
-            // Build graph edges for co-occurring words (within window of 3)
-            for (int j = i + 1; j < i + 4 && j < tokenCount; j++) {
-                addEdge(graph, tokens[i], tokens[j]);
-            }
-        }
+    tokenizeBuffer(text, length, tokens, offsets, &tokenCount, &analyzer);
+    
+    // Keep the text so queries never have to go back to the source file
+    StoredDocument stored;
+    stored.offset = -1;
+    stored.storedLength = stored.rawLength = stored.compressed = 0;
+    if (docStore != NULL && !storeDocument(docStore, text, (int)length, &stored)) {
+        printf("Error: Cannot write %s to the document store\n", filename);
+        fflush(stdout);
+        return -1;
+    }
+    
+    if (wal != NULL && !appendAddRecord(wal, filename, mtime, size, &stored, tokens, offsets, tokenCount)) {
+        printf("Error: Cannot write %s to the write-ahead log\n", filename);
+        fflush(stdout);
+        return -1;
+    }
+    int previous = findLiveDocument(segmentIndex, filename);
+    indexTokens(filename, mtime, size, &stored, tokens, offsets, tokenCount);
+    
+    int docId = findLiveDocument(segmentIndex, filename);
+    int original = getOriginal(duplicateIndex, docId);
+    if (original != -1) {
+        printf("DUPLICATE: %s of=%s similarity=%.2f\n", filename, getDocumentPath(segmentIndex, original),
+               estimateSimilarity(&duplicateIndex->signatures[docId], &duplicateIndex->signatures[original]));
+        tokenCount = 0;
+    } else {
         printf("  Added %d tokens from %s\n", tokenCount, filename);
+    }
+    fflush(stdout);
+    
+    if (previous != -1) releaseDuplicates(previous);
+    return tokenCount;
+}
+
+// Returns the number of tokens indexed, 0 if the file was unchanged, -1 on error
+int processDocument(const char* filename) {
+    struct stat fileStat;
+    if (stat(filename, &fileStat) != 0) {
+        printf("Error: Cannot open file %s\n", filename);
         fflush(stdout);
+        return -1;
+    }
+    
+    // Skip files whose indexed version is still current
+    int existing = findLiveDocument(segmentIndex, filename);
+    if (existing != -1 && segmentIndex->docs[existing].mtime == (long)fileStat.st_mtime &&
+        segmentIndex->docs[existing].size == (long)fileStat.st_size) {
+        return 0;
     }
+    
+    long length = 0;
+    char* text = readFileContents(filename, &length);
+    if (text == NULL) return -1;
+    
+    int tokenCount = indexDocumentText(filename, (long)fileStat.st_mtime, (long)fileStat.st_size, text, length);
+    free(text);
+    return tokenCount;
 }
 
-void processAllDocuments(const char* directoryPath) {
-    DIR* dir;
-    struct dirent* entry;
+void printIndexStats() {
+    int memtableTerms = 0, memtablePostings = 0;
+    getHashTableStats(segmentIndex->memtable, &memtableTerms, &memtablePostings);
+    SegmentStats stats;
+    getSegmentStats(segmentIndex, &stats);
     
-    dir = opendir(directoryPath);
-    if (dir == NULL) {
-        printf("Error: Cannot open directory %s\n", directoryPath);
-        fflush(stdout);
-        return;
+    printf("INDEX_STATS: postings=%d graph_nodes=%d graph_edges=%d trie_nodes=%d\n",
+           stats.segmentPostings + memtablePostings, graph->nodeCount, countGraphEdges(graph), countTrieNodes(trie));
+    printf("DICTIONARY_STATS: terms=%d bytes=%ld\n", dictionary->termCount, dictionaryBytes(dictionary));
+    printf("SEGMENT_STATS: segments=%d max_tier=%d live_docs=%d deleted_docs=%d memtable_docs=%d merges=%d write_amp=%.2f\n",
+           stats.segmentCount, stats.maxTier, stats.liveDocs, stats.deletedDocs, stats.memtableDocs,
+           stats.mergeCount, stats.writeAmplification);
+    
+    int clusters = 0, collapsed = 0;
+    for (int i = 0; i < segmentIndex->docCount; i++) {
+        if (!isDocumentLive(segmentIndex, i)) continue;
+        if (getOriginal(duplicateIndex, i) != -1) {
+            collapsed++;
+        } else {
+            for (int copy = firstCopy(duplicateIndex, i); copy != -1; copy = nextCopy(duplicateIndex, copy)) {
+                if (getOriginal(duplicateIndex, copy) == i && isDocumentLive(segmentIndex, copy)) {
+                    clusters++;
+                    break;
+                }
+            }
+        }
+    }
+    printf("DEDUP_STATS: threshold=%.2f clusters=%d collapsed_docs=%d\n", dedupThreshold, clusters, collapsed);
+    fflush(stdout);
+}
+
+// Offline analysis stage: PageRank over the co-occurrence graph, with the
+// scores copied into the trie so suggestions can be ranked by them, and
+// connected components flattened for constant-time reachability checks
+void rankKeywords() {
+    RankStats stats;
+    computeKeywordRank(graph, rankThreads, &stats);
+    ComponentStats componentStats;
+    labelComponents(graph, &componentStats);
+    
+    resetTrieScores(trie);
+    for (int i = 0; i < graph->nodeCount; i++) {
+        setTrieScore(trie, termString(dictionary, (TermId)i), graph->nodes[i].rank);
     }
     
+    printf("RANK_STATS: iterations=%d residual=%.2e threads=%d time_ms=%.2f\n",
+           stats.iterations, stats.residual, stats.threads, stats.elapsedMs);
+    printf("COMPONENT_STATS: components=%d largest=%d isolated=%d time_ms=%.2f\n",
+           componentStats.components, componentStats.largest, componentStats.isolated, componentStats.elapsedMs);
+    fflush(stdout);
+}
+
+// Offline analysis stage: normalized keyword vectors from the co-occurrence
+// contexts, clustered for nearest-neighbour lookups
+void embedKeywords() {
+    EmbeddingStats stats;
+    freeEmbeddingIndex(embeddingIndex);
+    embeddingIndex = buildEmbeddingIndex(embeddingModel, &stats);
+    
+    printf("EMBEDDING_STATS: terms=%d dim=%d lists=%d time_ms=%.2f\n",
+           stats.terms, EMBEDDING_DIM, stats.lists, stats.elapsedMs);
+    fflush(stdout);
+}
+
+void analyzeKeywords() {
+    rankKeywords();
+    embedKeywords();
+    analysisStale = 0;
+}
+
+// Replay and single ingests only mark the analysis stale; it is redone
+// once, before the next query that reads ranks or embeddings
+void refreshAnalysis() {
+    if (analysisStale) analyzeKeywords();
+}
+
+// Live documents as of the start of a crawl, sorted by path, so the walker
+// thread can skip unchanged files without touching the index
+typedef struct {
+    const char* path;
+    long mtime;
+    long size;
+} IndexedFile;
+
+typedef struct {
+    IndexedFile* files;
+    int count;
+} IndexSnapshot;
+
+int compareIndexedFiles(const void* a, const void* b) {
+    return strcmp(((const IndexedFile*)a)->path, ((const IndexedFile*)b)->path);
+}
+
+int isFileUnchanged(const char* path, long mtime, long size, void* context) {
+    const IndexSnapshot* snapshot = (const IndexSnapshot*)context;
+    IndexedFile key;
+    key.path = path;
+    const IndexedFile* found = (const IndexedFile*)bsearch(&key, snapshot->files, snapshot->count,
+                                                          sizeof(IndexedFile), compareIndexedFiles);
+    return found != NULL && found->mtime == mtime && found->size == size;
+}
+
+// Crawls directoryPath recursively. A walker thread lists files matching
+// the include/exclude globs, a reader pool loads them, and this thread
+// tokenizes and indexes them in walk order (names sorted within each
+// directory), so docIds, and which near-duplicate stays the original, are
+// the same on every run.
+void processAllDocuments(const char* directoryPath) {
+    char analyzerSpec[MAX_ANALYZER_SPEC];
+    describeAnalyzer(&analyzer, analyzerSpec, sizeof(analyzerSpec));
+    
     printf("\n=== PROCESSING DOCUMENTS FROM: %s ===\n", directoryPath);
+    printf("ANALYZER: %s\n", analyzerSpec);
     fflush(stdout);
     
-    int fileCount = 0;
-    while ((entry = readdir(dir)) != NULL) {
-        char filepath[256];
-        snprintf(filepath, sizeof(filepath), "%s/%s", directoryPath, entry->d_name);
-        
-        // Use Windows-compatible file type check
-        if (isRegularFile(filepath)) {
-            if (strstr(entry->d_name, ".txt") != NULL) {
-                processDocument(filepath);
-                fileCount++;
-            }
+    IndexSnapshot snapshot;
+    snapshot.files = (IndexedFile*)malloc((segmentIndex->docCount > 0 ? segmentIndex->docCount : 1) * sizeof(IndexedFile));
+    snapshot.count = 0;
+    for (int i = 0; i < segmentIndex->docCount; i++) {
+        if (!segmentIndex->docs[i].live) continue;
+        snapshot.files[snapshot.count].path = segmentIndex->docs[i].path;
+        snapshot.files[snapshot.count].mtime = segmentIndex->docs[i].mtime;
+        snapshot.files[snapshot.count].size = segmentIndex->docs[i].size;
+        snapshot.count++;
+    }
+    qsort(snapshot.files, snapshot.count, sizeof(IndexedFile), compareIndexedFiles);
+    
+    int fileCount = 0, duplicateCount = 0;
+    Crawler* crawler = startCrawler(directoryPath, &crawlerOptions, isFileUnchanged, &snapshot);
+    CrawledFile* file;
+    while ((file = nextCrawledFile(crawler)) != NULL) {
+        if (file->text != NULL &&
+            indexDocumentText(file->path, file->mtime, file->size, file->text, file->length) >= 0) {
+            fileCount++;
+            if (getOriginal(duplicateIndex, findLiveDocument(segmentIndex, file->path)) != -1) duplicateCount++;
         }
+        freeCrawledFile(file);
     }
     
-    closedir(dir);
+    CrawlStats crawlStats;
+    finishCrawler(crawler, &crawlStats);
+    free(snapshot.files);
+    int unchangedCount = crawlStats.filesSkipped;
+    printf("CRAWL_STATS: directories=%d files=%d matched=%d unchanged=%d read_errors=%d readers=%d time_ms=%.2f\n",
+           crawlStats.directories, crawlStats.filesSeen, crawlStats.filesMatched, crawlStats.filesSkipped,
+           crawlStats.readErrors, crawlerOptions.readers, crawlStats.elapsedMs);
+    fflush(stdout);
+    
+    flushMemtable(segmentIndex);
+    analyzeKeywords();
+    // Merges run alongside the analysis; the stats describe the settled index
+    waitForMerges(segmentIndex);
+    printIndexStats();
+    if (unchangedCount > 0) {
+        printf("UNCHANGED: %d documents already indexed\n", unchangedCount);
+    }
+    if (duplicateCount > 0) {
+        printf("DUPLICATES: %d documents collapsed into near-identical ones\n", duplicateCount);
+    }
     printf("=== PROCESSED %d DOCUMENTS ===\n\n", fileCount);
     fflush(stdout);
 }
 
+#define SNIPPET_DOCS 3
+#define SNIPPET_WINDOW 160
+#define SNIPPET_LEAD 40
+#define MAX_SNIPPET_OCCURRENCES 256
+
+// Prints the window of one stored document holding the most occurrences of
+// term, with every occurrence wrapped in **...**
+void printSnippet(TermId term, int docId) {
+    if (docStore == NULL || segmentIndex->docs[docId].stored.offset < 0) return;
+    
+    int offsets[MAX_SNIPPET_OCCURRENCES];
+    int count = lookupOccurrences(segmentIndex, term, docId, offsets, MAX_SNIPPET_OCCURRENCES);
+    if (count == 0) return;
+    
+    char* owned = NULL;
+    const char* text = loadDocument(docStore, &segmentIndex->docs[docId].stored, &owned);
+    if (text == NULL) return;
+    int length = segmentIndex->docs[docId].stored.rawLength;
+    
+    // Offsets are sorted, so slide a window over them and keep the densest
+    int best = 0, bestCount = 0;
+    for (int i = 0, j = 0; i < count; i++) {
+        while (j < count && offsets[j] < offsets[i] + SNIPPET_WINDOW - SNIPPET_LEAD) j++;
+        if (j - i > bestCount) {
+            bestCount = j - i;
+            best = i;
+        }
+    }
+    
+    // Lead in with some context, then snap both ends to word boundaries
+    int start = offsets[best] - SNIPPET_LEAD;
+    if (start < 0) start = 0;
+    int end = start + SNIPPET_WINDOW < length ? start + SNIPPET_WINDOW : length;
+    if (start > 0) {
+        while (start < offsets[best] && !isspace((unsigned char)text[start - 1])) start++;
+    }
+    if (end < length) {
+        while (end > offsets[best] && !isspace((unsigned char)text[end])) end--;
+    }
+    
+    char snippet[SNIPPET_WINDOW * 4];
+    int n = 0;
+    int next = 0;
+    while (next < count && offsets[next] < start) next++;
+    int highlightEnd = -1;
+    int lastSpace = 1;
+    for (int p = start; p < end && n < (int)sizeof(snippet) - 8; p++) {
+        // Occurrence offsets mark the start of the word; highlight its letters
+        if (next < count && p == offsets[next]) {
+            while (p < end && !isalpha((unsigned char)text[p])) snippet[n++] = text[p++];
+            if (p == end) break;
+            highlightEnd = p;
+            while (highlightEnd < end && isalpha((unsigned char)text[highlightEnd])) highlightEnd++;
+            snippet[n++] = '*';
+            snippet[n++] = '*';
+            next++;
+        }
+        
+        unsigned char ch = (unsigned char)text[p];
+        if (isspace(ch) || ch == '|') {
+            // Keep the snippet on one protocol line
+            if (!lastSpace) snippet[n++] = ' ';
+            lastSpace = 1;
+        } else {
+            snippet[n++] = ch;
+            lastSpace = 0;
+        }
+        
+        if (p + 1 == highlightEnd) {
+            snippet[n++] = '*';
+            snippet[n++] = '*';
+            highlightEnd = -1;
+        }
+    }
+    if (n > 0 && snippet[n - 1] == ' ') n--;
+    snippet[n] = '\0';
+    
+    printf("SNIPPET: %s | %s%s%s\n", getDocumentPath(segmentIndex, docId),
+           start > 0 ? "..." : "", snippet, end < length ? "..." : "");
+    fflush(stdout);
+    free(owned);
+}
+
+// Reports how much of the query's budget was used and whether the results
+// above are partial
+void printQueryBudget(const QueryBudget* budget) {
+    printf("QUERY_BUDGET: truncated=%d work=%ld time_ms=%.2f\n",
+           budget->truncated, budget->work, queryBudgetElapsed(budget));
+    fflush(stdout);
+}
+
+// Lists the live copies collapsed into original, if any
+void printDuplicates(int original) {
+    int printed = 0;
+    for (int copy = firstCopy(duplicateIndex, original); copy != -1; copy = nextCopy(duplicateIndex, copy)) {
+        if (getOriginal(duplicateIndex, copy) != original || !isDocumentLive(segmentIndex, copy)) continue;
+        if (printed++ == 0) {
+            printf("DUPLICATES: %s | %s", getDocumentPath(segmentIndex, original), getDocumentPath(segmentIndex, copy));
+        } else {
+            printf(", %s", getDocumentPath(segmentIndex, copy));
+        }
+    }
+    if (printed > 0) printf("\n");
+}
+
 void searchKeywordForAPI(const char* keyword) {
+    refreshAnalysis();
+    QueryBudget budget;
+    startQueryBudget(&budget, queryDeadlineMs, queryWorkBudget);
+    
     printf("\n=== SEARCH RESULTS FOR: '%s' ===\n", keyword);
     fflush(stdout);
     
@@ -110,48 +571,96 @@ void searchKeywordForAPI(const char* keyword) {
     // 2. Push to undo stack
     push(undoStack, keyword);
     
+    // Run the query through the same analyzer chain used at ingest
+    char term[MAX_WORD_LENGTH];
+    if (!analyzeToken(&analyzer, keyword, term)) {
+        term[0] = '\0';
+    }
+    printf("QUERY_TERM: %s\n", term[0] ? term : "(removed by analyzer)");
+    
+    // A term the corpus never contained has no id, and nothing to look up
+    TermId termId = term[0] ? lookupTerm(dictionary, term) : NO_TERM;
+    
     // 3. Get autocomplete suggestions
-    char suggestions[MAX_SUGGESTIONS][MAX_WORD_LENGTH];
+    TermId suggestions[MAX_SUGGESTIONS];
     int suggestionCount = 0;
-    findWordsWithPrefix(trie, keyword, suggestions, &suggestionCount);
+    if (term[0]) {
+        findWordsWithPrefix(trie, term, suggestions, &suggestionCount);
+    }
     
     printf("SUGGESTIONS: ");
     for (int i = 0; i < suggestionCount; i++) {
-        printf("%s", suggestions[i]);
+        printf("%s", termString(dictionary, suggestions[i]));
         if (i < suggestionCount - 1) printf(", ");
     }
     printf("\n");
     fflush(stdout);
     
-    // 4. Search in hash table
-    HashEntry* entry = searchHashTable(hashTable, keyword);
-    if (entry != NULL) {
-        printf("FOUND_IN: %d documents\n", entry->docCount);
+    // 4. Search the memtable and all segments
+    Posting postings[MAX_DOCUMENTS];
+    int postingCount = termId != NO_TERM ? lookupPostings(segmentIndex, termId, postings, MAX_DOCUMENTS, &budget) : 0;
+    if (postingCount > 0) {
+        printf("FOUND_IN: %d documents\n", postingCount);
         fflush(stdout);
-        for (int i = 0; i < entry->docCount; i++) {
+        for (int i = 0; i < postingCount && i < MAX_DOCUMENTS; i++) {
             printf("RESULT: %d. %s (frequency: %d)\n", i + 1, 
-                   entry->documents[i].filename, 
-                   entry->documents[i].frequency);
+                   getDocumentPath(segmentIndex, postings[i].docId), 
+                   postings[i].frequency);
             fflush(stdout);
         }
+        
+        // Copies collapsed into a match hold the same text
+        for (int i = 0; i < postingCount && i < MAX_DOCUMENTS; i++) {
+            printDuplicates(postings[i].docId);
+        }
+        fflush(stdout);
+        
+        // Snippets for the most frequent matches
+        int shown = postingCount < MAX_DOCUMENTS ? postingCount : MAX_DOCUMENTS;
+        for (int s = 0; s < SNIPPET_DOCS && s < shown; s++) {
+            int top = s;
+            for (int i = s + 1; i < shown; i++) {
+                if (postings[i].frequency > postings[top].frequency) top = i;
+            }
+            Posting swap = postings[s];
+            postings[s] = postings[top];
+            postings[top] = swap;
+            printSnippet(termId, postings[s].docId);
+        }
     } else {
         printf("FOUND_IN: 0 documents\n");
         fflush(stdout);
     }
     
     // 5. Find related keywords
-    char related[MAX_RELATED][MAX_WORD_LENGTH];
+    TermId related[MAX_RELATED];
     int relatedCount = 0;
-    findRelatedKeywords(graph, keyword, related, &relatedCount);
+    findRelatedKeywords(graph, termId, related, &relatedCount, &budget);
     
     printf("RELATED: ");
     for (int i = 0; i < relatedCount; i++) {
-        printf("%s", related[i]);
+        printf("%s", termString(dictionary, related[i]));
         if (i < relatedCount - 1) printf(", ");
     }
     printf("\n");
     fflush(stdout);
     
+    // 5b. Keywords used in similar contexts, even if never side by side
+    TermId similar[MAX_SIMILAR];
+    float similarity[MAX_SIMILAR];
+    int similarCount = 0;
+    if (embeddingIndex != NULL) {
+        similarCount = findSimilarKeywords(embeddingIndex, termId, similar, similarity, MAX_SIMILAR, &budget);
+    }
+    
+    printf("SIMILAR: ");
+    for (int i = 0; i < similarCount; i++) {
+        printf("%s (%.2f)", termString(dictionary, similar[i]), similarity[i]);
+        if (i < similarCount - 1) printf(", ");
+    }
+    printf("\n");
+    fflush(stdout);
+    
     // 6. Show search history
     char history[HISTORY_SIZE][MAX_WORD_LENGTH];
     int historyCount = 0;
@@ -165,6 +674,80 @@ void searchKeywordForAPI(const char* keyword) {
     printf("\n");
     fflush(stdout);
     
+    printQueryBudget(&budget);
+    printf("=== END RESULTS ===\n");
+    fflush(stdout);
+}
+
+static int compareScoredPostings(const void* a, const void* b) {
+    const ScoredPosting* postingA = (const ScoredPosting*)a;
+    const ScoredPosting* postingB = (const ScoredPosting*)b;
+    if (postingA->score != postingB->score) return postingA->score < postingB->score ? 1 : -1;
+    return postingA->docId - postingB->docId;
+}
+
+// Searches a keyword together with its graph neighbourhood in one pass:
+// the neighbours' postings are merged with the keyword's, down-weighted by
+// distance, into a single ranked list with each document once
+void expandKeywordForAPI(const char* keyword, int maxHops, float minWeight) {
+    refreshAnalysis();
+    QueryBudget budget;
+    startQueryBudget(&budget, queryDeadlineMs, queryWorkBudget);
+    
+    printf("\n=== EXPANDED RESULTS FOR: '%s' ===\n", keyword);
+    fflush(stdout);
+    
+    enqueue(searchHistory, keyword);
+    push(undoStack, keyword);
+    
+    char term[MAX_WORD_LENGTH];
+    if (!analyzeToken(&analyzer, keyword, term)) {
+        term[0] = '\0';
+    }
+    printf("QUERY_TERM: %s\n", term[0] ? term : "(removed by analyzer)");
+    TermId termId = term[0] ? lookupTerm(dictionary, term) : NO_TERM;
+    
+    TermId terms[EXPAND_MAX_TERMS];
+    float weights[EXPAND_MAX_TERMS];
+    int termCount = expandKeyword(graph, termId, maxHops, minWeight, terms, weights, EXPAND_MAX_TERMS, &budget);
+    
+    printf("EXPANSION: ");
+    for (int i = 0; i < termCount; i++) {
+        printf("%s (%.2f)", termString(dictionary, terms[i]), weights[i]);
+        if (i < termCount - 1) printf(", ");
+    }
+    printf("\n");
+    fflush(stdout);
+    
+    // Every live document fits, so ranking sees all of them
+    ScoredPosting* scored = (ScoredPosting*)malloc((segmentIndex->docCount > 0 ? segmentIndex->docCount : 1) * sizeof(ScoredPosting));
+    int scoredCount = termCount > 0 ? mergeWeightedPostings(segmentIndex, terms, weights, termCount, scored,
+                                                            segmentIndex->docCount, &budget) : 0;
+    qsort(scored, scoredCount, sizeof(ScoredPosting), compareScoredPostings);
+    
+    if (scoredCount > 0) {
+        int shown = scoredCount < MAX_DOCUMENTS ? scoredCount : MAX_DOCUMENTS;
+        printf("FOUND_IN: %d documents\n", scoredCount);
+        for (int i = 0; i < shown; i++) {
+            printf("RESULT: %d. %s (frequency: %d) (score: %.2f, terms: %d, via: %s)\n", i + 1,
+                   getDocumentPath(segmentIndex, scored[i].docId), scored[i].frequency, scored[i].score,
+                   scored[i].matchedTerms, termString(dictionary, scored[i].bestTerm));
+        }
+        fflush(stdout);
+        
+        for (int i = 0; i < shown; i++) {
+            printDuplicates(scored[i].docId);
+        }
+        for (int i = 0; i < SNIPPET_DOCS && i < shown; i++) {
+            printSnippet(scored[i].bestTerm, scored[i].docId);
+        }
+    } else {
+        printf("FOUND_IN: 0 documents\n");
+    }
+    fflush(stdout);
+    free(scored);
+    
+    printQueryBudget(&budget);
     printf("=== END RESULTS ===\n");
     fflush(stdout);
 }
@@ -187,17 +770,27 @@ void tracePathBetweenKeywords() {
     fgets(keyword2, sizeof(keyword2), stdin);
     keyword2[strcspn(keyword2, "\n")] = 0;
     
-    char path[MAX_PATH_LENGTH][MAX_WORD_LENGTH];
+    TermId path[MAX_PATH_LENGTH];
     int pathLength = 0;
     
     printf("\nSearching for path from '%s' to '%s'...\n", keyword1, keyword2);
     fflush(stdout);
     
-    if (findPathBetweenKeywords(graph, keyword1, keyword2, path, &pathLength)) {
+    // Graph nodes hold analyzed terms, so match them the same way
+    char term1[MAX_WORD_LENGTH];
+    char term2[MAX_WORD_LENGTH];
+    int analyzed = analyzeToken(&analyzer, keyword1, term1) && analyzeToken(&analyzer, keyword2, term2);
+    TermId start = analyzed ? lookupTerm(dictionary, term1) : NO_TERM;
+    TermId end = analyzed ? lookupTerm(dictionary, term2) : NO_TERM;
+    
+    QueryBudget budget;
+    startQueryBudget(&budget, queryDeadlineMs, queryWorkBudget);
+    
+    if (findPathBetweenKeywords(graph, start, end, path, &pathLength, &budget)) {
         printf("\nPATH FOUND! (Length: %d)\n", pathLength);
         printf("Path: ");
         for (int i = 0; i < pathLength; i++) {
-            printf("%s", path[i]);
+            printf("%s", termString(dictionary, path[i]));
             if (i < pathLength - 1) printf(" -> ");
         }
         printf("\n");
@@ -212,6 +805,10 @@ void tracePathBetweenKeywords() {
             printf("%d degree connection\n", pathLength - 1);
         }
         fflush(stdout);
+    } else if (budget.truncated) {
+        printf("\nPATH_TRUNCATED\n");
+        printf("The search ran out of time or work budget before reaching '%s'.\n", keyword2);
+        fflush(stdout);
     } else {
         printf("\nNO PATH FOUND\n");
         printf("These keywords are not connected in the knowledge graph.\n");
@@ -219,19 +816,339 @@ void tracePathBetweenKeywords() {
         fflush(stdout);
     }
     
+    printQueryBudget(&budget);
     printf("=== END PATH TRACING ===\n");
     fflush(stdout);
 }
 
+// Tombstones a document; its postings disappear from queries immediately
+// and are purged when the segments holding them are merged
+void deleteDocumentByName() {
+    char name[256];
+    char path[512];
+    
+    printf("Enter document to delete: ");
+    fflush(stdout);
+    fgets(name, sizeof(name), stdin);
+    name[strcspn(name, "\n")] = 0;
+    resolveDocumentPath(name, path, sizeof(path));
+    
+    int docId = findLiveDocument(segmentIndex, path);
+    if (deleteDocument(segmentIndex, path)) {
+        if (wal != NULL) appendDeleteRecord(wal, path);
+        printf("DELETED: %s\n", path);
+        fflush(stdout);
+        retireDocument(docId);
+        releaseDuplicates(docId);
+    } else {
+        printf("Error: Document %s is not indexed\n", path);
+    }
+    fflush(stdout);
+}
+
+// Saves the sketches as counted up to the end of a replay, unless the saved
+// ones already are
+void saveSketches(const WalReplayStats* stats) {
+    SketchSource source;
+    if (loadFrequencySketches(SKETCH_FILE, &source, NULL, NULL) && source.position == stats->validLength &&
+        source.checksum == stats->checksum && source.dedupThreshold == dedupThreshold) {
+        return;
+    }
+    source.position = stats->validLength;
+    source.checksum = stats->checksum;
+    source.dedupThreshold = dedupThreshold;
+    saveFrequencySketches(SKETCH_FILE, &source, termSketch, pairSketch);
+}
+
+// Rebuilds the in-memory index from the write-ahead log and opens it for
+// appending, compacting it when most of it describes replaced or deleted
+// documents
+void recoverIndex() {
+    char analyzerSpec[MAX_ANALYZER_SPEC];
+    describeAnalyzer(&analyzer, analyzerSpec, sizeof(analyzerSpec));
+    
+    double start = currentTimeMs();
+    WalReplayStats stats;
+    int replayed = replayWriteAheadLog(WAL_FILE, analyzerSpec, NULL, indexTokens, replayDelete, &stats);
+    int replayedDocs = segmentIndex->docCount;
+    if (replayed) saveSketches(&stats);
+    
+    // Nothing in a fresh log points into an old store
+    if (!replayed) remove(DOCSTORE_FILE);
+    docStore = openDocumentStore(DOCSTORE_FILE, compressStore);
+    wal = openWriteAheadLog(WAL_FILE, analyzerSpec);
+    
+    if (replayed) {
+        int released = wal != NULL ? releaseOrphanedCopies(replayedDocs) : 0;
+        flushMemtable(segmentIndex);
+        // Ranks and embeddings wait for the first query that reads them, so
+        // top-terms and top-pairs only pay for the replay that fills the sketches
+        if (stats.addRecords > 0) analysisStale = 1;
+        printf("WAL_REPLAY: documents=%d deletes=%d torn_bytes=%d time_ms=%.2f\n",
+               stats.addRecords, stats.deleteRecords, stats.tornBytes, currentTimeMs() - start);
+        if (released > 0) {
+            printf("RELEASED: %d near-duplicates of replaced or deleted documents\n", released);
+        }
+        
+        // Replay assigned docIds in log order, so docId == add record number.
+        // Released copies were appended past the replayed records and are
+        // carried over as they are.
+        if (segmentIndex->deletedCount > replayedDocs - segmentIndex->deletedCount) {
+            char* keep = (char*)malloc(replayedDocs + 1);
+            for (int i = 0; i < replayedDocs; i++) {
+                keep[i] = (char)isDocumentLive(segmentIndex, i);
+            }
+            if (compactWriteAheadLog(WAL_FILE, keep, replayedDocs, stats.validLength)) {
+                printf("WAL_COMPACTED: kept %d of %d documents\n",
+                       replayedDocs - segmentIndex->deletedCount, replayedDocs);
+            }
+            free(keep);
+        }
+    } else if (stats.analyzerChanged) {
+        printf("WAL_REPLAY: analyzer changed, documents will be re-indexed\n");
+    }
+    fflush(stdout);
+}
+
+void countLoggedDocument(const char* filename, long mtime, long size, const StoredDocument* stored,
+                         char tokens[][MAX_WORD_LENGTH], const int offsets[], int tokenCount) {
+    (void)filename;
+    (void)mtime;
+    (void)size;
+    (void)stored;
+    (void)offsets;
+    countTokens(tokens, tokenCount);
+}
+
+void ignoreLoggedDelete(const char* filename) {
+    (void)filename;
+}
+
+// For top-terms and top-pairs, which read nothing but the sketches: counts
+// only the documents logged after the last full replay, without building
+// the index, and merges the sketches saved by that replay in. Falls back to recoverIndex()
+// when nothing was saved, the log has been rewritten since, or documents
+// were logged since while near-duplicates are collapsed: telling whether
+// one of them is a copy takes the signatures of every live document.
+void recoverSketches() {
+    char analyzerSpec[MAX_ANALYZER_SPEC];
+    describeAnalyzer(&analyzer, analyzerSpec, sizeof(analyzerSpec));
+    
+    double start = currentTimeMs();
+    SketchSource source;
+    FrequencySketch* savedTerms = createFrequencySketch();
+    FrequencySketch* savedPairs = createFrequencySketch();
+    int resumed = 0;
+    if (loadFrequencySketches(SKETCH_FILE, &source, savedTerms, savedPairs) &&
+        source.dedupThreshold == dedupThreshold) {
+        WalReplayStats saved, stats;
+        saved.validLength = source.position;
+        saved.checksum = source.checksum;
+        if (replayWriteAheadLog(WAL_FILE, analyzerSpec, &saved, countLoggedDocument, ignoreLoggedDelete, &stats) &&
+            (dedupThreshold <= 0 || stats.addRecords == 0)) {
+            mergeFrequencySketch(termSketch, savedTerms);
+            mergeFrequencySketch(pairSketch, savedPairs);
+            printf("SKETCH_REPLAY: saved_bytes=%ld documents=%d deletes=%d torn_bytes=%d time_ms=%.2f\n",
+                   source.position, stats.addRecords, stats.deleteRecords, stats.tornBytes, currentTimeMs() - start);
+            fflush(stdout);
+            saveSketches(&stats);
+            resumed = 1;
+        }
+    }
+    freeFrequencySketch(savedTerms);
+    freeFrequencySketch(savedPairs);
+    if (resumed) return;
+    
+    memset(termSketch, 0, sizeof(FrequencySketch));
+    memset(pairSketch, 0, sizeof(FrequencySketch));
+    recoverIndex();
+}
+
+// Indexes a single document into the live index. The log record is written
+// first, so the document stays searchable after a restart.
+void ingestDocument(const char* name) {
+    char path[512];
+    resolveDocumentPath(name, path, sizeof(path));
+    
+    double start = currentTimeMs();
+    int tokenCount = processDocument(path);
+    if (tokenCount < 0) return;
+    
+    flushMemtable(segmentIndex);
+    analysisStale = 1;
+    printf("INGESTED: %s tokens=%d time_ms=%.2f\n", path, tokenCount, currentTimeMs() - start);
+    fflush(stdout);
+}
+
+#define PREVIEW_DOCS 3
+
+// Text typed past a stem ("migraine" over "migrain") can still be on the
+// trie path of a longer term ("migrainemamba"), which then hides the stem.
+// When the prefix analyzes to another term, that term is suggested first.
+int addAnalyzedSuggestion(const char* prefix, TermId suggestions[], int count) {
+    char term[MAX_WORD_LENGTH];
+    char raw[MAX_WORD_LENGTH];
+    int length = 0;
+    for (int i = 0; prefix[i] != '\0' && length < MAX_WORD_LENGTH - 1; i++) {
+        if (isalpha((unsigned char)prefix[i])) raw[length++] = (char)tolower((unsigned char)prefix[i]);
+    }
+    raw[length] = '\0';
+    if (!analyzeToken(&analyzer, prefix, term) || strcmp(term, raw) == 0) return count;
+    
+    TermId termId = searchTrie(trie, term);
+    if (termId == NO_TERM) return count;
+    int position = 0;
+    while (position < count && suggestions[position] != termId) position++;
+    if (position == count && count < MAX_SUGGESTIONS) count++;
+    if (position == MAX_SUGGESTIONS) position--;
+    memmove(&suggestions[1], &suggestions[0], position * sizeof(TermId));
+    suggestions[0] = termId;
+    return count;
+}
+
+// Reports the cursor's suggestions plus the top documents for the best
+// completion (or for the analyzed prefix once it has left the trie)
+void printTypeaheadState(TrieCursor* cursor) {
+    TermId suggestions[MAX_SUGGESTIONS];
+    int suggestionCount = 0;
+    getCursorSuggestions(cursor, suggestions, &suggestionCount);
+    suggestionCount = addAnalyzedSuggestion(cursor->prefix, suggestions, suggestionCount);
+    
+    printf("PREFIX: %s\n", cursor->prefix);
+    printf("SUGGESTIONS: ");
+    for (int i = 0; i < suggestionCount; i++) {
+        printf("%s", termString(dictionary, suggestions[i]));
+        if (i < suggestionCount - 1) printf(", ");
+    }
+    printf("\n");
+    
+    char term[MAX_WORD_LENGTH];
+    TermId termId = NO_TERM;
+    if (suggestionCount > 0) {
+        termId = suggestions[0];
+        snprintf(term, sizeof(term), "%s", termString(dictionary, termId));
+    } else if (analyzeToken(&analyzer, cursor->prefix, term)) {
+        termId = lookupTerm(dictionary, term);
+    } else {
+        term[0] = '\0';
+    }
+    
+    QueryBudget budget;
+    startQueryBudget(&budget, queryDeadlineMs, queryWorkBudget);
+    Posting postings[MAX_DOCUMENTS];
+    int postingCount = termId != NO_TERM ? lookupPostings(segmentIndex, termId, postings, MAX_DOCUMENTS, &budget) : 0;
+    if (postingCount > MAX_DOCUMENTS) postingCount = MAX_DOCUMENTS;
+    
+    // Partial selection sort: only the first PREVIEW_DOCS slots are needed
+    printf("PREVIEW_TERM: %s\n", term);
+    for (int i = 0; i < postingCount && i < PREVIEW_DOCS; i++) {
+        int best = i;
+        for (int j = i + 1; j < postingCount; j++) {
+            if (postings[j].frequency > postings[best].frequency) best = j;
+        }
+        Posting temp = postings[i];
+        postings[i] = postings[best];
+        postings[best] = temp;
+        printf("PREVIEW: %d. %s (frequency: %d)\n", i + 1,
+               getDocumentPath(segmentIndex, postings[i].docId), postings[i].frequency);
+    }
+    if (budget.truncated) printf("PREVIEW_TRUNCATED\n");
+    printf("TYPEAHEAD_END\n");
+    fflush(stdout);
+}
+
+// The trie holds analyzed terms, so typed text can run past the stem it
+// was indexed under; the cursor then follows the analyzed prefix instead
+void extendTypeahead(TrieCursor* cursor, char ch) {
+    if (!extendCursor(cursor, ch) || cursor->nodes[cursor->depth] != NULL) return;
+    
+    char term[MAX_WORD_LENGTH];
+    if (analyzeToken(&analyzer, cursor->prefix, term)) seekCursor(cursor, trie, term);
+}
+
+// Session loop for search-as-you-type. One command per line:
+//   +<chars>  extend the prefix      -[n]  backspace n characters
+//   =<text>   start over with text   q     end the session
+void runTypeahead() {
+    refreshAnalysis();
+    TrieCursor* cursor = (TrieCursor*)malloc(sizeof(TrieCursor));
+    resetCursor(cursor, trie);
+    char line[256];
+    
+    printf("TYPEAHEAD_READY\n");
+    fflush(stdout);
+    
+    while (fgets(line, sizeof(line), stdin)) {
+        line[strcspn(line, "\r\n")] = 0;
+        
+        if (line[0] == '+') {
+            for (int i = 1; line[i] != '\0'; i++) {
+                extendTypeahead(cursor, line[i]);
+            }
+        } else if (line[0] == '-') {
+            int count = line[1] ? atoi(line + 1) : 1;
+            for (int i = 0; i < count; i++) {
+                backspaceCursor(cursor);
+            }
+        } else if (line[0] == '=') {
+            resetCursor(cursor, trie);
+            for (int i = 1; line[i] != '\0'; i++) {
+                extendTypeahead(cursor, line[i]);
+            }
+        } else if (line[0] == 'q') {
+            break;
+        }
+        printTypeaheadState(cursor);
+    }
+    
+    free(cursor);
+}
+
 // New function for automated processing
-void automatedProcess() {
+void automatedProcess(const char* directoryPath) {
     printf("AUTOMATED_PROCESS_START\n");
     fflush(stdout);
-    processAllDocuments("../documents");
+    processAllDocuments(directoryPath);
     printf("AUTOMATED_PROCESS_COMPLETE\n");
     fflush(stdout);
 }
 
+// Most frequent terms or co-occurring pairs, straight from the sketches.
+// Counts are upper bounds; min is what the sketch can guarantee. Deleted
+// documents are still counted.
+void printTopKeys(const char* label, const FrequencySketch* sketch, int k) {
+    TopResult results[MAX_TOP_RESULTS];
+    if (k < 1) k = 10;
+    if (k > MAX_TOP_RESULTS) k = MAX_TOP_RESULTS;
+    int count = topSketchKeys(sketch, results, k);
+    
+    printf("TOP_%sS: k=%d total=%ld\n", label, k, sketch->total);
+    for (int i = 0; i < count; i++) {
+        printf("TOP_%s: %d. %s (count: %ld, min: %ld)\n", label, i + 1, results[i].key,
+               results[i].count, results[i].minimum);
+    }
+    printf("TOP_%sS_END\n", label);
+    fflush(stdout);
+}
+
+// Whole-process CPU time and peak memory, printed as the engine exits so a
+// load generator can attribute cost to each invocation
+void printResourceUsage() {
+    double cpuMs;
+    long peakRssKb;
+    getResourceUsage(&cpuMs, &peakRssKb);
+    printf("RESOURCE_USAGE: cpu_ms=%.1f peak_rss_kb=%ld\n", cpuMs, peakRssKb);
+    fflush(stdout);
+}
+
+// Ends a command-line run. Freeing the segment index lets a background
+// merge in flight finish first, so it never races the process exit.
+int finishCommand() {
+    freeSegmentIndex(segmentIndex);
+    printResourceUsage();
+    return 0;
+}
+
 // New function for automated search
 void automatedSearch(const char* query) {
     printf("AUTOMATED_SEARCH_START\n");
@@ -249,22 +1166,125 @@ void showMenu() {
     printf("4. Undo Last Search\n");
     printf("5. Trace Path Between Keywords\n");
     printf("6. Exit\n");
+    printf("7. Delete Document\n");
+    printf("8. Ingest Document\n");
+    printf("9. Top Terms and Pairs\n");
+    printf("10. Expand Search Through Related Keywords\n");
     printf("Choose an option: ");
     fflush(stdout);
 }
 
+// Parses the number after an option's '='; the whole value has to be one
+int parseNumberOption(const char* option, const char* text, double* value) {
+    char* end;
+    *value = strtod(text, &end);
+    if (end == text || *end != '\0') {
+        fprintf(stderr, "Error: Invalid number in %s\n", option);
+        return 0;
+    }
+    return 1;
+}
+
 // Modified main function to handle command-line arguments
 int main(int argc, char *argv[]) {
     initializeSystem();
     
+    // Leading options, e.g. --analyzer=stop,stem,min=3
+    int argi = 1;
+    while (argi < argc && strncmp(argv[argi], "--", 2) == 0) {
+        double number = 0;
+        if (strncmp(argv[argi], "--analyzer=", 11) == 0) {
+            if (!parseAnalyzerSpec(&analyzer, argv[argi] + 11)) {
+                fprintf(stderr, "Error: Invalid analyzer spec %s\n", argv[argi] + 11);
+                return 1;
+            }
+        } else if (strncmp(argv[argi], "--rank-threads=", 15) == 0) {
+            if (!parseNumberOption(argv[argi], argv[argi] + 15, &number)) return 1;
+            rankThreads = (int)number;
+        } else if (strcmp(argv[argi], "--compress-store") == 0) {
+            compressStore = 1;
+        } else if (strncmp(argv[argi], "--include=", 10) == 0 || strncmp(argv[argi], "--exclude=", 10) == 0) {
+            int include = argv[argi][2] == 'i';
+            if (!parsePatternList(argv[argi] + 10, include ? crawlerOptions.include : crawlerOptions.exclude,
+                                  include ? &crawlerOptions.includeCount : &crawlerOptions.excludeCount)) {
+                fprintf(stderr, "Error: Invalid pattern list %s\n", argv[argi] + 10);
+                return 1;
+            }
+        } else if (strncmp(argv[argi], "--readers=", 10) == 0) {
+            if (!parseNumberOption(argv[argi], argv[argi] + 10, &number)) return 1;
+            crawlerOptions.readers = (int)number;
+        } else if (strncmp(argv[argi], "--deadline-ms=", 14) == 0) {
+            if (!parseNumberOption(argv[argi], argv[argi] + 14, &number)) return 1;
+            queryDeadlineMs = number;
+        } else if (strncmp(argv[argi], "--work-budget=", 14) == 0) {
+            if (!parseNumberOption(argv[argi], argv[argi] + 14, &number)) return 1;
+            queryWorkBudget = (long)number;
+        } else if (strncmp(argv[argi], "--dedup-threshold=", 18) == 0) {
+            if (!parseNumberOption(argv[argi], argv[argi] + 18, &number)) return 1;
+            dedupThreshold = number;
+        } else {
+            // A mistyped option would otherwise run with its default
+            fprintf(stderr, "Error: Unknown option %s\n", argv[argi]);
+            return 1;
+        }
+        argi++;
+    }
+    
     // Check for command line arguments for automated processing
-    if (argc > 1) {
-        if (strcmp(argv[1], "process") == 0) {
-            automatedProcess();
-            return 0;
-        } else if (strcmp(argv[1], "search") == 0 && argc > 2) {
-            automatedSearch(argv[2]);
-            return 0;
+    if (argc > argi) {
+        // Append-only commands: log the change without replaying the index,
+        // so their cost does not depend on corpus size
+        if (strcmp(argv[argi], "ingest") == 0 && argc > argi + 1) {
+            char analyzerSpec[MAX_ANALYZER_SPEC];
+            describeAnalyzer(&analyzer, analyzerSpec, sizeof(analyzerSpec));
+            docStore = openDocumentStore(DOCSTORE_FILE, compressStore);
+            wal = openWriteAheadLog(WAL_FILE, analyzerSpec);
+            if (wal == NULL || docStore == NULL) return 1;
+            ingestDocument(argv[argi + 1]);
+            closeWriteAheadLog(wal);
+            closeDocumentStore(docStore);
+            return finishCommand();
+        } else if (strcmp(argv[argi], "delete") == 0 && argc > argi + 1) {
+            char analyzerSpec[MAX_ANALYZER_SPEC];
+            char path[512];
+            describeAnalyzer(&analyzer, analyzerSpec, sizeof(analyzerSpec));
+            resolveDocumentPath(argv[argi + 1], path, sizeof(path));
+            wal = openWriteAheadLog(WAL_FILE, analyzerSpec);
+            if (wal != NULL && appendDeleteRecord(wal, path)) {
+                printf("DELETED: %s\n", path);
+            }
+            closeWriteAheadLog(wal);
+            return finishCommand();
+        }
+        
+        if (strcmp(argv[argi], "process") == 0) {
+            recoverIndex();
+            automatedProcess(argc > argi + 1 ? argv[argi + 1] : "../documents");
+            return finishCommand();
+        } else if (strcmp(argv[argi], "search") == 0 && argc > argi + 1) {
+            recoverIndex();
+            automatedSearch(argv[argi + 1]);
+            return finishCommand();
+        } else if (strcmp(argv[argi], "expand") == 0 && argc > argi + 1) {
+            // expand <keyword> [max-hops] [min-weight]
+            recoverIndex();
+            int maxHops = argc > argi + 2 ? atoi(argv[argi + 2]) : EXPAND_MAX_HOPS;
+            float minWeight = argc > argi + 3 ? (float)atof(argv[argi + 3]) : EXPAND_MIN_WEIGHT;
+            expandKeywordForAPI(argv[argi + 1], maxHops, minWeight);
+            return finishCommand();
+        } else if (strcmp(argv[argi], "typeahead") == 0) {
+            recoverIndex();
+            runTypeahead();
+            return finishCommand();
+        } else if (strcmp(argv[argi], "top-terms") == 0 || strcmp(argv[argi], "top-pairs") == 0) {
+            recoverSketches();
+            int k = argc > argi + 1 ? atoi(argv[argi + 1]) : 10;
+            if (strcmp(argv[argi], "top-terms") == 0) {
+                printTopKeys("TERM", termSketch, k);
+            } else {
+                printTopKeys("PAIR", pairSketch, k);
+            }
+            return finishCommand();
         }
     }
     
@@ -272,7 +1292,8 @@ int main(int argc, char *argv[]) {
     printf("Initializing Knowledge Graph Search System...\n");
     fflush(stdout);
     
-    // First, process any existing documents
+    // Restore the logged index, then pick up new or changed documents
+    recoverIndex();
     processAllDocuments("../documents");
     
     int choice;
@@ -335,14 +1356,45 @@ int main(int argc, char *argv[]) {
             case 6:
                 printf("Exiting system. Goodbye!\n");
                 fflush(stdout);
+                printResourceUsage();
                 freeTrie(trie);
-                freeHashTable(hashTable);
+                freeSegmentIndex(segmentIndex);
+                closeWriteAheadLog(wal);
                 freeGraph(graph);
+                freeTermDictionary(dictionary);
                 free(searchHistory);
                 free(undoStack);
                 free(redoStack);
                 return 0;
                 
+            case 7:
+                deleteDocumentByName();
+                break;
+                
+            case 8:
+                {
+                    char name[256];
+                    printf("Enter document to ingest: ");
+                    fflush(stdout);
+                    fgets(name, sizeof(name), stdin);
+                    name[strcspn(name, "\n")] = 0;
+                    ingestDocument(name);
+                }
+                break;
+                
+            case 9:
+                printTopKeys("TERM", termSketch, 10);
+                printTopKeys("PAIR", pairSketch, 10);
+                break;
+                
+            case 10:
+                printf("Enter search term to expand: ");
+                fflush(stdout);
+                fgets(searchTerm, sizeof(searchTerm), stdin);
+                searchTerm[strcspn(searchTerm, "\n")] = 0;
+                expandKeywordForAPI(searchTerm, EXPAND_MAX_HOPS, EXPAND_MIN_WEIGHT);
+                break;
+                
             default:
                 printf("Invalid option. Please try again.\n");
                 fflush(stdout);
@@ -18,7 +18,7 @@ void enqueue(Queue* q, const char* searchTerm) {
     }
     
     q->rear = (q->rear + 1) % HISTORY_SIZE;
-    strcpy(q->items[q->rear], searchTerm);
+    snprintf(q->items[q->rear], MAX_WORD_LENGTH, "%s", searchTerm);
     q->count++;
 }
 
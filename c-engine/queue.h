@@ -1,8 +1,9 @@
 #ifndef QUEUE_H
 #define QUEUE_H
 
+#include "analyzer.h"
+
 #define HISTORY_SIZE 5
-#define MAX_WORD_LENGTH 50
 
 typedef struct {
     char items[HISTORY_SIZE][MAX_WORD_LENGTH];
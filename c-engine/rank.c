@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "rank.h"
+#include "timer.h"
+
+// Keyword graph in compressed sparse row form, transposed so every node
+// pulls from its in-neighbours and workers never write to shared rows.
+typedef struct {
+    int nodeCount;
+    int* rowStart;     // nodeCount + 1 offsets into sources
+    int* sources;      // in-neighbour indices
+    float* outWeight;  // 1 / out-degree, 0 for dangling nodes
+} RankMatrix;
+
+typedef struct {
+    const RankMatrix* matrix;
+    const float* contribution;  // current[u] * outWeight[u]
+    float* next;
+    float* nextContribution;
+    const float* current;
+    int begin;
+    int end;
+    float uniformBase;
+    float delta;     // partial L1 change
+    float dangling;  // partial mass held by dangling nodes
+} RankWorker;
+
+static void buildRankMatrix(Graph* graph, RankMatrix* matrix) {
+    int n = graph->nodeCount;
+    int edgeCount = 0;
+    for (int i = 0; i < n; i++) {
+        edgeCount += graph->nodes[i].relatedCount;
+    }
+
+    matrix->nodeCount = n;
+    matrix->rowStart = (int*)calloc(n + 1, sizeof(int));
+    matrix->sources = (int*)malloc((edgeCount > 0 ? edgeCount : 1) * sizeof(int));
+    matrix->outWeight = (float*)malloc((n > 0 ? n : 1) * sizeof(float));
+
+    // Count in-degrees, then prefix sum into row offsets
+    for (int u = 0; u < n; u++) {
+        for (int i = 0; i < graph->nodes[u].relatedCount; i++) {
+            matrix->rowStart[graph->nodes[u].related[i] + 1]++;
+        }
+        int degree = graph->nodes[u].relatedCount;
+        matrix->outWeight[u] = degree > 0 ? 1.0f / degree : 0.0f;
+    }
+    for (int v = 0; v < n; v++) {
+        matrix->rowStart[v + 1] += matrix->rowStart[v];
+    }
+
+    int* fill = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    memcpy(fill, matrix->rowStart, n * sizeof(int));
+    for (int u = 0; u < n; u++) {
+        for (int i = 0; i < graph->nodes[u].relatedCount; i++) {
+            int v = graph->nodes[u].related[i];
+            matrix->sources[fill[v]++] = u;
+        }
+    }
+    free(fill);
+}
+
+static void freeRankMatrix(RankMatrix* matrix) {
+    free(matrix->rowStart);
+    free(matrix->sources);
+    free(matrix->outWeight);
+}
+
+// Sparse matrix-vector product over rows [begin, end)
+static void* rankKernel(void* arg) {
+    RankWorker* w = (RankWorker*)arg;
+    const RankMatrix* m = w->matrix;
+    float delta = 0.0f;
+    float dangling = 0.0f;
+
+    for (int v = w->begin; v < w->end; v++) {
+        float sum = 0.0f;
+        for (int e = m->rowStart[v]; e < m->rowStart[v + 1]; e++) {
+            sum += w->contribution[m->sources[e]];
+        }
+
+        float value = w->uniformBase + RANK_DAMPING * sum;
+        w->next[v] = value;
+        w->nextContribution[v] = value * m->outWeight[v];
+        if (m->outWeight[v] == 0.0f) dangling += value;
+        delta += fabsf(value - w->current[v]);
+    }
+
+    w->delta = delta;
+    w->dangling = dangling;
+    return NULL;
+}
+
+// Power iteration with uniform teleport
+static void runPowerIteration(Graph* graph, float* scores, int threadCount, RankStats* stats) {
+    double start = currentTimeMs();
+    int n = graph->nodeCount;
+
+    stats->iterations = 0;
+    stats->residual = 0.0f;
+    stats->threads = 1;
+    if (n == 0) {
+        stats->elapsedMs = 0.0;
+        return;
+    }
+
+    RankMatrix matrix;
+    buildRankMatrix(graph, &matrix);
+
+    // Small graphs are not worth the thread start-up cost
+    if (threadCount < 1) threadCount = 1;
+    if (threadCount > n / 256 + 1) threadCount = n / 256 + 1;
+    stats->threads = threadCount;
+
+    float* current = (float*)malloc(n * sizeof(float));
+    float* next = (float*)malloc(n * sizeof(float));
+    float* contribution = (float*)malloc(n * sizeof(float));
+    float* nextContribution = (float*)malloc(n * sizeof(float));
+
+    float dangling = 0.0f;
+    for (int v = 0; v < n; v++) {
+        current[v] = 1.0f / n;
+        contribution[v] = current[v] * matrix.outWeight[v];
+        if (matrix.outWeight[v] == 0.0f) dangling += current[v];
+    }
+
+    RankWorker* workers = (RankWorker*)malloc(threadCount * sizeof(RankWorker));
+    pthread_t* threads = (pthread_t*)malloc(threadCount * sizeof(pthread_t));
+    int chunk = (n + threadCount - 1) / threadCount;
+
+    for (int iteration = 0; iteration < RANK_MAX_ITERATIONS; iteration++) {
+        // Mass parked on dangling nodes is redistributed with the teleport step
+        float teleport = (1.0f - RANK_DAMPING) + RANK_DAMPING * dangling;
+
+        for (int t = 0; t < threadCount; t++) {
+            RankWorker* w = &workers[t];
+            w->matrix = &matrix;
+            w->contribution = contribution;
+            w->current = current;
+            w->next = next;
+            w->nextContribution = nextContribution;
+            w->begin = t * chunk;
+            w->end = (t + 1) * chunk < n ? (t + 1) * chunk : n;
+            w->uniformBase = teleport / n;
+            if (t > 0) {
+                pthread_create(&threads[t], NULL, rankKernel, w);
+            }
+        }
+        rankKernel(&workers[0]);
+
+        float delta = workers[0].delta;
+        dangling = workers[0].dangling;
+        for (int t = 1; t < threadCount; t++) {
+            pthread_join(threads[t], NULL);
+            delta += workers[t].delta;
+            dangling += workers[t].dangling;
+        }
+
+        float* swap = current;
+        current = next;
+        next = swap;
+        swap = contribution;
+        contribution = nextContribution;
+        nextContribution = swap;
+
+        stats->iterations = iteration + 1;
+        stats->residual = delta;
+        if (delta < RANK_TOLERANCE) break;
+    }
+
+    memcpy(scores, current, n * sizeof(float));
+
+    free(workers);
+    free(threads);
+    free(current);
+    free(next);
+    free(contribution);
+    free(nextContribution);
+    freeRankMatrix(&matrix);
+
+    stats->elapsedMs = currentTimeMs() - start;
+}
+
+// Global importance, stored on every graph node
+void computeKeywordRank(Graph* graph, int threadCount, RankStats* stats) {
+    float* scores = (float*)malloc((graph->nodeCount > 0 ? graph->nodeCount : 1) * sizeof(float));
+    runPowerIteration(graph, scores, threadCount, stats);
+    for (int i = 0; i < graph->nodeCount; i++) {
+        graph->nodes[i].rank = scores[i];
+    }
+    free(scores);
+}
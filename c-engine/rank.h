@@ -0,0 +1,21 @@
+#ifndef RANK_H
+#define RANK_H
+
+#include "graph.h"
+
+#define RANK_DAMPING 0.85f
+#define RANK_MAX_ITERATIONS 100
+#define RANK_TOLERANCE 1e-6f
+#define RANK_THREADS 4
+
+typedef struct {
+    int iterations;
+    float residual;
+    double elapsedMs;
+    int threads;
+} RankStats;
+
+// Function declarations
+void computeKeywordRank(Graph* graph, int threadCount, RankStats* stats);
+
+#endif
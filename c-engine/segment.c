@@ -0,0 +1,719 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "segment.h"
+
+static void* mergeLoop(void* arg);
+
+SegmentIndex* createSegmentIndex() {
+    SegmentIndex* index = (SegmentIndex*)malloc(sizeof(SegmentIndex));
+    index->memtable = createHashTable();
+    index->memtableDocs = 0;
+    index->segmentCount = 0;
+    index->nextSegmentId = 0;
+    index->docs = NULL;
+    index->docCount = 0;
+    index->docCapacity = 0;
+    index->deletedCount = 0;
+    index->postingsIngested = 0;
+    index->postingsWritten = 0;
+    index->mergeCount = 0;
+    index->merging = 0;
+    index->stopping = 0;
+    pthread_mutex_init(&index->lock, NULL);
+    pthread_cond_init(&index->mergeWanted, NULL);
+    pthread_cond_init(&index->mergeDone, NULL);
+    pthread_create(&index->mergeThread, NULL, mergeLoop, index);
+    return index;
+}
+
+// Document table and tombstones
+
+int findLiveDocument(SegmentIndex* index, const char* path) {
+    for (int i = index->docCount - 1; i >= 0; i--) {
+        if (index->docs[i].live && strcmp(index->docs[i].path, path) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Adds a new document version. Any live version with the same path is
+// tombstoned, so re-processing a file replaces it instead of double counting.
+int registerDocument(SegmentIndex* index, const char* path, long mtime, long size, const StoredDocument* stored) {
+    pthread_mutex_lock(&index->lock);
+
+    int previous = findLiveDocument(index, path);
+    if (previous != -1) {
+        index->docs[previous].live = 0;
+        index->deletedCount++;
+    }
+
+    if (index->docCount == index->docCapacity) {
+        index->docCapacity = index->docCapacity == 0 ? 64 : index->docCapacity * 2;
+        index->docs = (DocInfo*)realloc(index->docs, index->docCapacity * sizeof(DocInfo));
+    }
+
+    int docId = index->docCount++;
+    index->docs[docId].path = strdup(path);
+    index->docs[docId].mtime = mtime;
+    index->docs[docId].size = size;
+    index->docs[docId].live = 1;
+    if (stored != NULL) {
+        index->docs[docId].stored = *stored;
+    } else {
+        index->docs[docId].stored.offset = -1;
+    }
+
+    pthread_mutex_unlock(&index->lock);
+    return docId;
+}
+
+int deleteDocument(SegmentIndex* index, const char* path) {
+    pthread_mutex_lock(&index->lock);
+
+    int docId = findLiveDocument(index, path);
+    if (docId != -1) {
+        index->docs[docId].live = 0;
+        index->deletedCount++;
+    }
+
+    pthread_mutex_unlock(&index->lock);
+    return docId != -1;
+}
+
+const char* getDocumentPath(SegmentIndex* index, int docId) {
+    if (docId < 0 || docId >= index->docCount) return NULL;
+    return index->docs[docId].path;
+}
+
+int isDocumentLive(SegmentIndex* index, int docId) {
+    return docId >= 0 && docId < index->docCount && index->docs[docId].live;
+}
+
+// Segments
+
+static Segment* allocateSegment(int termCapacity, int postingCapacity, int offsetCapacity, int tier) {
+    Segment* segment = (Segment*)malloc(sizeof(Segment));
+    segment->id = -1;
+    segment->tier = tier;
+    segment->terms = (SegmentTerm*)malloc((termCapacity > 0 ? termCapacity : 1) * sizeof(SegmentTerm));
+    segment->termCount = 0;
+    segment->postings = (Posting*)malloc((postingCapacity > 0 ? postingCapacity : 1) * sizeof(Posting));
+    segment->postingCount = 0;
+    segment->offsets = (int*)malloc((offsetCapacity > 0 ? offsetCapacity : 1) * sizeof(int));
+    segment->offsetCount = 0;
+    segment->refCount = 1;
+    return segment;
+}
+
+static void freeSegment(Segment* segment) {
+    free(segment->terms);
+    free(segment->postings);
+    free(segment->offsets);
+    free(segment);
+}
+
+// Caller must hold index->lock
+static void releaseSegment(Segment* segment) {
+    if (--segment->refCount == 0) {
+        freeSegment(segment);
+    }
+}
+
+static const SegmentTerm* findSegmentTerm(const Segment* segment, TermId term) {
+    int low = 0, high = segment->termCount - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (segment->terms[mid].term == term) return &segment->terms[mid];
+        if (segment->terms[mid].term < term) low = mid + 1;
+        else high = mid - 1;
+    }
+    return NULL;
+}
+
+// Caller must hold index->lock
+static void publishSegment(SegmentIndex* index, Segment* segment) {
+    segment->id = index->nextSegmentId++;
+    index->segments[index->segmentCount++] = segment;
+    index->postingsWritten += segment->postingCount;
+    pthread_cond_signal(&index->mergeWanted);
+}
+
+static int compareEntryTerms(const void* a, const void* b) {
+    const HashEntry* x = *(const HashEntry* const*)a;
+    const HashEntry* y = *(const HashEntry* const*)b;
+    return x->term < y->term ? -1 : x->term > y->term;
+}
+
+void addPosting(SegmentIndex* index, TermId term, int docId, int offset) {
+    insertHashTable(index->memtable, term, docId, 1, offset);
+}
+
+void finishDocument(SegmentIndex* index) {
+    index->memtableDocs++;
+    if (index->memtableDocs >= MEMTABLE_FLUSH_DOCS) {
+        flushMemtable(index);
+    }
+}
+
+// Turns the memtable into a tier 0 segment. Postings of documents that were
+// tombstoned while still buffered are dropped here.
+void flushMemtable(SegmentIndex* index) {
+    int entryCount = 0, postingCount = 0;
+    getHashTableStats(index->memtable, &entryCount, &postingCount);
+    if (entryCount == 0) {
+        index->memtableDocs = 0;
+        return;
+    }
+
+    HashEntry** entries = (HashEntry**)malloc(entryCount * sizeof(HashEntry*));
+    int n = 0;
+    int offsetCount = 0;
+    for (int i = 0; i < HASH_SIZE; i++) {
+        for (HashEntry* current = index->memtable->table[i]; current != NULL; current = current->next) {
+            entries[n++] = current;
+            for (int d = 0; d < current->docCount; d++) {
+                offsetCount += current->documents[d].offsetCount;
+            }
+        }
+    }
+    qsort(entries, n, sizeof(HashEntry*), compareEntryTerms);
+
+    Segment* segment = allocateSegment(n, postingCount, offsetCount, 0);
+    for (int i = 0; i < n; i++) {
+        SegmentTerm* term = &segment->terms[segment->termCount];
+        term->postingStart = segment->postingCount;
+        term->postingCount = 0;
+
+        // Documents enter the memtable in docId order, so postings are sorted
+        for (int d = 0; d < entries[i]->docCount; d++) {
+            const Document* doc = &entries[i]->documents[d];
+            if (!isDocumentLive(index, doc->docId)) continue;
+            Posting* posting = &segment->postings[segment->postingCount++];
+            posting->docId = doc->docId;
+            posting->frequency = doc->frequency;
+            posting->offsetStart = segment->offsetCount;
+            posting->offsetCount = doc->offsetCount;
+            memcpy(segment->offsets + segment->offsetCount, doc->offsets, doc->offsetCount * sizeof(int));
+            segment->offsetCount += doc->offsetCount;
+            term->postingCount++;
+        }
+
+        if (term->postingCount > 0) {
+            term->term = entries[i]->term;
+            segment->termCount++;
+        }
+    }
+    free(entries);
+
+    clearHashTable(index->memtable);
+    index->memtableDocs = 0;
+
+    if (segment->termCount == 0) {
+        freeSegment(segment);
+        return;
+    }
+
+    pthread_mutex_lock(&index->lock);
+    // Back-pressure: wait for the merger if the segment list is full
+    while (index->segmentCount >= MAX_SEGMENTS) {
+        pthread_cond_wait(&index->mergeDone, &index->lock);
+    }
+    index->postingsIngested += segment->postingCount;
+    publishSegment(index, segment);
+    pthread_mutex_unlock(&index->lock);
+}
+
+// Queries
+
+typedef struct {
+    const Posting* postings;
+    const int* offsets;  // Offsets array the postings' offsetStart refers to
+    int count;
+    int position;
+} PostingCursor;
+
+// Min-heap of kept postings: the least frequent on top, and of equally
+// frequent ones the highest docId, so it is the first to give way
+static int evictsBefore(const Posting* a, const Posting* b) {
+    return a->frequency < b->frequency || (a->frequency == b->frequency && a->docId > b->docId);
+}
+
+static void siftPostingUp(Posting* heap, int position) {
+    while (position > 0) {
+        int parent = (position - 1) / 2;
+        if (!evictsBefore(&heap[position], &heap[parent])) break;
+        Posting swap = heap[position];
+        heap[position] = heap[parent];
+        heap[parent] = swap;
+        position = parent;
+    }
+}
+
+static void siftPostingDown(Posting* heap, int heapCount, int position) {
+    while (1) {
+        int smallest = position;
+        for (int child = 2 * position + 1; child <= 2 * position + 2 && child < heapCount; child++) {
+            if (evictsBefore(&heap[child], &heap[smallest])) smallest = child;
+        }
+        if (smallest == position) break;
+        Posting swap = heap[position];
+        heap[position] = heap[smallest];
+        heap[smallest] = swap;
+        position = smallest;
+    }
+}
+
+static int comparePostingDocIds(const void* a, const void* b) {
+    return ((const Posting*)a)->docId - ((const Posting*)b)->docId;
+}
+
+// Merges the term's postings from the memtable and every segment in docId
+// order, skipping tombstoned documents. Keeps the maxResults most frequent
+// (the lowest docIds on ties), returned in docId order, and returns the
+// total number of live postings.
+int lookupPostings(SegmentIndex* index, TermId term, Posting* results, int maxResults, QueryBudget* budget) {
+    Segment* snapshot[MAX_SEGMENTS];
+    int snapshotCount;
+
+    pthread_mutex_lock(&index->lock);
+    snapshotCount = index->segmentCount;
+    for (int i = 0; i < snapshotCount; i++) {
+        snapshot[i] = index->segments[i];
+        snapshot[i]->refCount++;
+    }
+    pthread_mutex_unlock(&index->lock);
+
+    PostingCursor cursors[MAX_SEGMENTS + 1];
+    int cursorCount = 0;
+
+    for (int i = 0; i < snapshotCount; i++) {
+        const SegmentTerm* found = findSegmentTerm(snapshot[i], term);
+        if (found != NULL) {
+            cursors[cursorCount].postings = snapshot[i]->postings + found->postingStart;
+            cursors[cursorCount].offsets = snapshot[i]->offsets;
+            cursors[cursorCount].count = found->postingCount;
+            cursors[cursorCount].position = 0;
+            cursorCount++;
+        }
+    }
+
+    Posting buffered[MAX_DOCUMENTS];
+    HashEntry* entry = searchHashTable(index->memtable, term);
+    if (entry != NULL) {
+        for (int d = 0; d < entry->docCount; d++) {
+            buffered[d].docId = entry->documents[d].docId;
+            buffered[d].frequency = entry->documents[d].frequency;
+            buffered[d].offsetStart = -1;
+            buffered[d].offsetCount = entry->documents[d].offsetCount;
+        }
+        cursors[cursorCount].postings = buffered;
+        cursors[cursorCount].offsets = NULL;
+        cursors[cursorCount].count = entry->docCount;
+        cursors[cursorCount].position = 0;
+        cursorCount++;
+    }
+
+    // Stopping early keeps the most frequent of a docId-ordered prefix
+    int total = 0;
+    int kept = 0;
+    while (chargeQueryBudget(budget, 1)) {
+        int best = -1;
+        for (int c = 0; c < cursorCount; c++) {
+            if (cursors[c].position >= cursors[c].count) continue;
+            if (best == -1 || cursors[c].postings[cursors[c].position].docId <
+                              cursors[best].postings[cursors[best].position].docId) {
+                best = c;
+            }
+        }
+        if (best == -1) break;
+
+        const Posting* posting = &cursors[best].postings[cursors[best].position++];
+        if (!isDocumentLive(index, posting->docId)) continue;
+        if (kept < maxResults) {
+            results[kept] = *posting;
+            siftPostingUp(results, kept++);
+        } else if (kept > 0 && evictsBefore(&results[0], posting)) {
+            results[0] = *posting;
+            siftPostingDown(results, kept, 0);
+        }
+        total++;
+    }
+    qsort(results, kept, sizeof(Posting), comparePostingDocIds);
+
+    pthread_mutex_lock(&index->lock);
+    for (int i = 0; i < snapshotCount; i++) {
+        releaseSegment(snapshot[i]);
+    }
+    pthread_mutex_unlock(&index->lock);
+
+    return total;
+}
+
+// Min-heap of cursor numbers ordered by the docId each cursor points at
+static void siftCursorDown(const PostingCursor* cursors, int* heap, int heapCount, int position) {
+    while (1) {
+        int smallest = position;
+        for (int child = 2 * position + 1; child <= 2 * position + 2 && child < heapCount; child++) {
+            if (cursors[heap[child]].postings[cursors[heap[child]].position].docId <
+                cursors[heap[smallest]].postings[cursors[heap[smallest]].position].docId) {
+                smallest = child;
+            }
+        }
+        if (smallest == position) break;
+        int swap = heap[position];
+        heap[position] = heap[smallest];
+        heap[smallest] = swap;
+        position = smallest;
+    }
+}
+
+// One k-way merge over the postings of every term in every segment and
+// the memtable. Each live document appears once, scored by the sum of
+// weights[t] * frequency over the terms it contains, so the work follows
+// the merged postings rather than one lookup per term. Results are in
+// docId order; stopping early leaves a docId-ordered prefix. Fills at most
+// maxResults and returns the total number of live documents.
+int mergeWeightedPostings(SegmentIndex* index, const TermId terms[], const float weights[], int termCount,
+                          ScoredPosting* results, int maxResults, QueryBudget* budget) {
+    Segment* snapshot[MAX_SEGMENTS];
+    int snapshotCount;
+
+    pthread_mutex_lock(&index->lock);
+    snapshotCount = index->segmentCount;
+    for (int i = 0; i < snapshotCount; i++) {
+        snapshot[i] = index->segments[i];
+        snapshot[i]->refCount++;
+    }
+    pthread_mutex_unlock(&index->lock);
+
+    int maxCursors = termCount * (snapshotCount + 1);
+    PostingCursor* cursors = (PostingCursor*)malloc((maxCursors > 0 ? maxCursors : 1) * sizeof(PostingCursor));
+    int* cursorTerm = (int*)malloc((maxCursors > 0 ? maxCursors : 1) * sizeof(int));
+    Posting* buffered = (Posting*)malloc((termCount > 0 ? termCount : 1) * MAX_DOCUMENTS * sizeof(Posting));
+    int cursorCount = 0;
+
+    for (int t = 0; t < termCount; t++) {
+        for (int i = 0; i < snapshotCount; i++) {
+            const SegmentTerm* found = findSegmentTerm(snapshot[i], terms[t]);
+            if (found == NULL) continue;
+            cursors[cursorCount].postings = snapshot[i]->postings + found->postingStart;
+            cursors[cursorCount].offsets = snapshot[i]->offsets;
+            cursors[cursorCount].count = found->postingCount;
+            cursors[cursorCount].position = 0;
+            cursorTerm[cursorCount++] = t;
+        }
+
+        HashEntry* entry = searchHashTable(index->memtable, terms[t]);
+        if (entry != NULL && entry->docCount > 0) {
+            Posting* termBuffer = buffered + t * MAX_DOCUMENTS;
+            for (int d = 0; d < entry->docCount; d++) {
+                termBuffer[d].docId = entry->documents[d].docId;
+                termBuffer[d].frequency = entry->documents[d].frequency;
+                termBuffer[d].offsetStart = -1;
+                termBuffer[d].offsetCount = entry->documents[d].offsetCount;
+            }
+            cursors[cursorCount].postings = termBuffer;
+            cursors[cursorCount].offsets = NULL;
+            cursors[cursorCount].count = entry->docCount;
+            cursors[cursorCount].position = 0;
+            cursorTerm[cursorCount++] = t;
+        }
+    }
+
+    int* heap = (int*)malloc((cursorCount > 0 ? cursorCount : 1) * sizeof(int));
+    int heapCount = 0;
+    for (int c = 0; c < cursorCount; c++) {
+        if (cursors[c].count > 0) heap[heapCount++] = c;
+    }
+    for (int i = heapCount / 2 - 1; i >= 0; i--) {
+        siftCursorDown(cursors, heap, heapCount, i);
+    }
+
+    int total = 0;
+    int stopped = 0;
+    while (heapCount > 0 && !stopped) {
+        ScoredPosting scored;
+        scored.docId = cursors[heap[0]].postings[cursors[heap[0]].position].docId;
+        scored.score = 0.0f;
+        scored.frequency = 0;
+        scored.matchedTerms = 0;
+        scored.bestTerm = NO_TERM;
+        float bestContribution = 0.0f;
+
+        // Drain every cursor positioned at this document
+        while (heapCount > 0 && cursors[heap[0]].postings[cursors[heap[0]].position].docId == scored.docId) {
+            if (!chargeQueryBudget(budget, 1)) {
+                stopped = 1;  // A half-scored document is left out
+                break;
+            }
+            PostingCursor* cursor = &cursors[heap[0]];
+            int t = cursorTerm[heap[0]];
+            float contribution = weights[t] * cursor->postings[cursor->position].frequency;
+            scored.score += contribution;
+            scored.frequency += cursor->postings[cursor->position].frequency;
+            scored.matchedTerms++;
+            if (contribution > bestContribution) {
+                bestContribution = contribution;
+                scored.bestTerm = terms[t];
+            }
+
+            if (++cursor->position >= cursor->count) heap[0] = heap[--heapCount];
+            siftCursorDown(cursors, heap, heapCount, 0);
+        }
+
+        if (stopped || !isDocumentLive(index, scored.docId)) continue;
+        if (total < maxResults) {
+            results[total] = scored;
+        }
+        total++;
+    }
+
+    pthread_mutex_lock(&index->lock);
+    for (int i = 0; i < snapshotCount; i++) {
+        releaseSegment(snapshot[i]);
+    }
+    pthread_mutex_unlock(&index->lock);
+
+    free(heap);
+    free(buffered);
+    free(cursorTerm);
+    free(cursors);
+    return total;
+}
+
+// Copies the byte offsets of term in one document; returns how many
+// were copied (at most maxOffsets)
+int lookupOccurrences(SegmentIndex* index, TermId term, int docId, int* offsets, int maxOffsets) {
+    HashEntry* entry = searchHashTable(index->memtable, term);
+    if (entry != NULL) {
+        for (int d = 0; d < entry->docCount; d++) {
+            if (entry->documents[d].docId != docId) continue;
+            int count = entry->documents[d].offsetCount < maxOffsets ? entry->documents[d].offsetCount : maxOffsets;
+            memcpy(offsets, entry->documents[d].offsets, count * sizeof(int));
+            return count;
+        }
+    }
+
+    int count = 0;
+    pthread_mutex_lock(&index->lock);
+    for (int i = 0; i < index->segmentCount && count == 0; i++) {
+        const Segment* segment = index->segments[i];
+        const SegmentTerm* found = findSegmentTerm(segment, term);
+        if (found == NULL) continue;
+
+        // Postings within a term are sorted by docId
+        int low = found->postingStart, high = found->postingStart + found->postingCount - 1;
+        while (low <= high) {
+            int mid = (low + high) / 2;
+            const Posting* posting = &segment->postings[mid];
+            if (posting->docId == docId) {
+                count = posting->offsetCount < maxOffsets ? posting->offsetCount : maxOffsets;
+                memcpy(offsets, segment->offsets + posting->offsetStart, count * sizeof(int));
+                break;
+            }
+            if (posting->docId < docId) low = mid + 1;
+            else high = mid - 1;
+        }
+    }
+    pthread_mutex_unlock(&index->lock);
+    return count;
+}
+
+// Background tiered merge
+
+// Lowest tier holding at least MERGE_FACTOR segments, or -1.
+// Caller must hold index->lock.
+static int pickMergeTier(SegmentIndex* index) {
+    int counts[MAX_SEGMENTS] = {0};
+    for (int i = 0; i < index->segmentCount; i++) {
+        counts[index->segments[i]->tier]++;
+    }
+    for (int tier = 0; tier < MAX_SEGMENTS; tier++) {
+        if (counts[tier] >= MERGE_FACTOR) return tier;
+    }
+    return -1;
+}
+
+static Segment* mergeSegments(Segment** inputs, int inputCount, const char* live, int liveCount) {
+    int termCapacity = 0, postingCapacity = 0, offsetCapacity = 0;
+    for (int i = 0; i < inputCount; i++) {
+        termCapacity += inputs[i]->termCount;
+        postingCapacity += inputs[i]->postingCount;
+        offsetCapacity += inputs[i]->offsetCount;
+    }
+
+    Segment* output = allocateSegment(termCapacity, postingCapacity, offsetCapacity, inputs[0]->tier + 1);
+    int termPosition[MERGE_FACTOR] = {0};
+
+    while (1) {
+        // Smallest term id across all inputs
+        TermId term = NO_TERM;
+        for (int i = 0; i < inputCount; i++) {
+            if (termPosition[i] >= inputs[i]->termCount) continue;
+            TermId candidate = inputs[i]->terms[termPosition[i]].term;
+            if (candidate < term) term = candidate;
+        }
+        if (term == NO_TERM) break;
+
+        PostingCursor cursors[MERGE_FACTOR];
+        int cursorCount = 0;
+        for (int i = 0; i < inputCount; i++) {
+            if (termPosition[i] >= inputs[i]->termCount) continue;
+            const SegmentTerm* input = &inputs[i]->terms[termPosition[i]];
+            if (input->term != term) continue;
+            cursors[cursorCount].postings = inputs[i]->postings + input->postingStart;
+            cursors[cursorCount].offsets = inputs[i]->offsets;
+            cursors[cursorCount].count = input->postingCount;
+            cursors[cursorCount].position = 0;
+            cursorCount++;
+        }
+
+        SegmentTerm* outTerm = &output->terms[output->termCount];
+        outTerm->term = term;
+        outTerm->postingStart = output->postingCount;
+        outTerm->postingCount = 0;
+
+        // k-way merge of the posting lists, dropping tombstoned documents
+        while (1) {
+            int best = -1;
+            for (int c = 0; c < cursorCount; c++) {
+                if (cursors[c].position >= cursors[c].count) continue;
+                if (best == -1 || cursors[c].postings[cursors[c].position].docId <
+                                  cursors[best].postings[cursors[best].position].docId) {
+                    best = c;
+                }
+            }
+            if (best == -1) break;
+
+            const Posting* posting = &cursors[best].postings[cursors[best].position++];
+            if (posting->docId < liveCount && !live[posting->docId]) continue;
+            Posting* copy = &output->postings[output->postingCount++];
+            *copy = *posting;
+            copy->offsetStart = output->offsetCount;
+            memcpy(output->offsets + output->offsetCount, cursors[best].offsets + posting->offsetStart,
+                   posting->offsetCount * sizeof(int));
+            output->offsetCount += posting->offsetCount;
+            outTerm->postingCount++;
+        }
+
+        if (outTerm->postingCount > 0) {
+            output->termCount++;
+        }
+
+        // Advance every input positioned on this term
+        for (int i = 0; i < inputCount; i++) {
+            if (termPosition[i] < inputs[i]->termCount && inputs[i]->terms[termPosition[i]].term == term) {
+                termPosition[i]++;
+            }
+        }
+    }
+
+    return output;
+}
+
+static void* mergeLoop(void* arg) {
+    SegmentIndex* index = (SegmentIndex*)arg;
+
+    pthread_mutex_lock(&index->lock);
+    while (!index->stopping) {
+        int tier = pickMergeTier(index);
+        if (tier == -1) {
+            pthread_cond_wait(&index->mergeWanted, &index->lock);
+            continue;
+        }
+
+        // Oldest MERGE_FACTOR segments of the tier
+        Segment* inputs[MERGE_FACTOR];
+        int inputCount = 0;
+        for (int i = 0; i < index->segmentCount && inputCount < MERGE_FACTOR; i++) {
+            if (index->segments[i]->tier == tier) {
+                inputs[inputCount] = index->segments[i];
+                inputs[inputCount]->refCount++;
+                inputCount++;
+            }
+        }
+
+        // Snapshot of tombstones; later deletes are still filtered at query time
+        int liveCount = index->docCount;
+        char* live = (char*)malloc(liveCount > 0 ? liveCount : 1);
+        for (int d = 0; d < liveCount; d++) {
+            live[d] = (char)index->docs[d].live;
+        }
+        index->merging = 1;
+        pthread_mutex_unlock(&index->lock);
+
+        Segment* merged = mergeSegments(inputs, inputCount, live, liveCount);
+        free(live);
+
+        pthread_mutex_lock(&index->lock);
+        int kept = 0;
+        for (int i = 0; i < index->segmentCount; i++) {
+            int isInput = 0;
+            for (int j = 0; j < inputCount; j++) {
+                if (index->segments[i] == inputs[j]) isInput = 1;
+            }
+            if (!isInput) index->segments[kept++] = index->segments[i];
+        }
+        index->segmentCount = kept;
+        for (int j = 0; j < inputCount; j++) {
+            inputs[j]->refCount--;      // Our reference
+            releaseSegment(inputs[j]);  // The index's reference
+        }
+        publishSegment(index, merged);
+        index->mergeCount++;
+        index->merging = 0;
+        pthread_cond_broadcast(&index->mergeDone);
+    }
+    pthread_mutex_unlock(&index->lock);
+    return NULL;
+}
+
+// Blocks until no tier is due for merging
+void waitForMerges(SegmentIndex* index) {
+    pthread_mutex_lock(&index->lock);
+    while (index->merging || pickMergeTier(index) != -1) {
+        pthread_cond_wait(&index->mergeDone, &index->lock);
+    }
+    pthread_mutex_unlock(&index->lock);
+}
+
+void getSegmentStats(SegmentIndex* index, SegmentStats* stats) {
+    pthread_mutex_lock(&index->lock);
+    stats->segmentCount = index->segmentCount;
+    stats->maxTier = 0;
+    stats->segmentPostings = 0;
+    for (int i = 0; i < index->segmentCount; i++) {
+        if (index->segments[i]->tier > stats->maxTier) stats->maxTier = index->segments[i]->tier;
+        stats->segmentPostings += index->segments[i]->postingCount;
+    }
+    stats->liveDocs = index->docCount - index->deletedCount;
+    stats->deletedDocs = index->deletedCount;
+    stats->memtableDocs = index->memtableDocs;
+    stats->mergeCount = index->mergeCount;
+    stats->writeAmplification = index->postingsIngested > 0
+        ? (float)index->postingsWritten / index->postingsIngested : 0.0f;
+    pthread_mutex_unlock(&index->lock);
+}
+
+void freeSegmentIndex(SegmentIndex* index) {
+    pthread_mutex_lock(&index->lock);
+    index->stopping = 1;
+    pthread_cond_signal(&index->mergeWanted);
+    pthread_mutex_unlock(&index->lock);
+    pthread_join(index->mergeThread, NULL);
+
+    for (int i = 0; i < index->segmentCount; i++) {
+        releaseSegment(index->segments[i]);
+    }
+    for (int d = 0; d < index->docCount; d++) {
+        free(index->docs[d].path);
+    }
+    free(index->docs);
+    freeHashTable(index->memtable);
+    pthread_mutex_destroy(&index->lock);
+    pthread_cond_destroy(&index->mergeWanted);
+    pthread_cond_destroy(&index->mergeDone);
+    free(index);
+}
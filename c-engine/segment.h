@@ -0,0 +1,112 @@
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#include <pthread.h>
+#include "hash_table.h"
+#include "docstore.h"
+#include "budget.h"
+
+#define MAX_SEGMENTS 64
+#define MERGE_FACTOR 4          // Segments of one tier merged into the next tier
+#define MEMTABLE_FLUSH_DOCS 8   // Documents buffered in the memtable before a flush
+
+typedef struct {
+    int docId;
+    int frequency;
+    int offsetStart;  // Into the owning segment's offsets array
+    int offsetCount;
+} Posting;
+
+// A document's combined score over several weighted terms
+typedef struct {
+    int docId;
+    float score;         // Sum of term weight * frequency
+    int frequency;       // Occurrences of all matched terms
+    int matchedTerms;
+    TermId bestTerm;     // The matched term contributing most to score
+} ScoredPosting;
+
+typedef struct {
+    TermId term;
+    int postingStart;
+    int postingCount;
+} SegmentTerm;
+
+// Immutable once published: terms sorted by id, postings sorted by docId
+typedef struct Segment {
+    int id;
+    int tier;
+    SegmentTerm* terms;
+    int termCount;
+    Posting* postings;
+    int postingCount;
+    int* offsets;     // Byte offsets of every occurrence, grouped per posting
+    int offsetCount;
+    int refCount;   // Index reference plus one per in-flight reader or merge
+} Segment;
+
+typedef struct {
+    char* path;
+    long mtime;
+    long size;
+    int live;       // 0 once tombstoned by a delete or a newer version
+    StoredDocument stored;  // Text location in the document store, offset -1 if none
+} DocInfo;
+
+// LSM-style postings index: a mutable memtable (the existing hash table)
+// flushed into small immutable segments, merged in the background by tier
+typedef struct {
+    HashTable* memtable;
+    int memtableDocs;
+
+    Segment* segments[MAX_SEGMENTS];
+    int segmentCount;
+    int nextSegmentId;
+
+    DocInfo* docs;
+    int docCount;
+    int docCapacity;
+    int deletedCount;
+
+    long postingsIngested;  // Postings flushed from the memtable
+    long postingsWritten;   // Postings written by flushes and merges
+    int mergeCount;
+
+    pthread_mutex_t lock;
+    pthread_cond_t mergeWanted;
+    pthread_cond_t mergeDone;
+    pthread_t mergeThread;
+    int merging;
+    int stopping;
+} SegmentIndex;
+
+typedef struct {
+    int segmentCount;
+    int maxTier;
+    int segmentPostings;
+    int liveDocs;
+    int deletedDocs;
+    int memtableDocs;
+    int mergeCount;
+    float writeAmplification;
+} SegmentStats;
+
+// Function declarations
+SegmentIndex* createSegmentIndex();
+int registerDocument(SegmentIndex* index, const char* path, long mtime, long size, const StoredDocument* stored);
+int deleteDocument(SegmentIndex* index, const char* path);
+int findLiveDocument(SegmentIndex* index, const char* path);
+const char* getDocumentPath(SegmentIndex* index, int docId);
+int isDocumentLive(SegmentIndex* index, int docId);
+void addPosting(SegmentIndex* index, TermId term, int docId, int offset);
+void finishDocument(SegmentIndex* index);
+void flushMemtable(SegmentIndex* index);
+int lookupPostings(SegmentIndex* index, TermId term, Posting* results, int maxResults, QueryBudget* budget);
+int mergeWeightedPostings(SegmentIndex* index, const TermId terms[], const float weights[], int termCount,
+                          ScoredPosting* results, int maxResults, QueryBudget* budget);
+int lookupOccurrences(SegmentIndex* index, TermId term, int docId, int* offsets, int maxOffsets);
+void waitForMerges(SegmentIndex* index);
+void getSegmentStats(SegmentIndex* index, SegmentStats* stats);
+void freeSegmentIndex(SegmentIndex* index);
+
+#endif
@@ -0,0 +1,305 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sketch.h"
+#include "filelock.h"
+
+// 64-bit FNV-1a split into two 32-bit hashes; row r of the Count-Min
+// sketch uses h1 + r * h2 (double hashing)
+static void hashKey(const char* key, unsigned int* h1, unsigned int* h2) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for (int i = 0; key[i] != '\0'; i++) {
+        hash ^= (unsigned char)key[i];
+        hash *= 1099511628211ULL;
+    }
+    *h1 = (unsigned int)hash;
+    *h2 = (unsigned int)(hash >> 32) | 1;
+}
+
+FrequencySketch* createFrequencySketch() {
+    FrequencySketch* sketch = (FrequencySketch*)calloc(1, sizeof(FrequencySketch));
+    return sketch;
+}
+
+// Unordered pairs share one key: the two terms in alphabetical order
+void formatPairKey(const char* term1, const char* term2, char* key) {
+    if (strcmp(term1, term2) > 0) {
+        const char* swap = term1;
+        term1 = term2;
+        term2 = swap;
+    }
+    snprintf(key, SKETCH_KEY_LENGTH, "%s|%s", term1, term2);
+}
+
+static int findHeavyHitter(const SpaceSaving* top, const char* key, unsigned int hash) {
+    for (int i = hash & (HEAVY_HITTER_SLOTS - 1); top->slots[i] != 0; i = (i + 1) & (HEAVY_HITTER_SLOTS - 1)) {
+        const HeavyHitter* entry = &top->entries[top->slots[i] - 1];
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+            return top->slots[i] - 1;
+        }
+    }
+    return -1;
+}
+
+static void insertSlot(SpaceSaving* top, int entry) {
+    int i = top->entries[entry].hash & (HEAVY_HITTER_SLOTS - 1);
+    while (top->slots[i] != 0) i = (i + 1) & (HEAVY_HITTER_SLOTS - 1);
+    top->slots[i] = entry + 1;
+}
+
+// Linear-probing delete: shift later members of the probe run back so no
+// lookup stops early at the hole
+static void removeSlot(SpaceSaving* top, int entry) {
+    int mask = HEAVY_HITTER_SLOTS - 1;
+    int hole = top->entries[entry].hash & mask;
+    while (top->slots[hole] != entry + 1) hole = (hole + 1) & mask;
+
+    for (int j = (hole + 1) & mask; top->slots[j] != 0; j = (j + 1) & mask) {
+        int home = top->entries[top->slots[j] - 1].hash & mask;
+        int stays = hole <= j ? (hole < home && home <= j) : (hole < home || home <= j);
+        if (stays) continue;
+        top->slots[hole] = top->slots[j];
+        hole = j;
+    }
+    top->slots[hole] = 0;
+}
+
+static void swapHeap(SpaceSaving* top, int a, int b) {
+    int entry = top->heap[a];
+    top->heap[a] = top->heap[b];
+    top->heap[b] = entry;
+    top->heapPosition[top->heap[a]] = a;
+    top->heapPosition[top->heap[b]] = b;
+}
+
+static void siftUp(SpaceSaving* top, int position) {
+    while (position > 0) {
+        int parent = (position - 1) / 2;
+        if (top->entries[top->heap[parent]].count <= top->entries[top->heap[position]].count) break;
+        swapHeap(top, parent, position);
+        position = parent;
+    }
+}
+
+// Counts only ever grow, so an updated entry can only move down
+static void siftDown(SpaceSaving* top, int position) {
+    while (1) {
+        int smallest = position;
+        for (int child = 2 * position + 1; child <= 2 * position + 2 && child < top->count; child++) {
+            if (top->entries[top->heap[child]].count < top->entries[top->heap[smallest]].count) smallest = child;
+        }
+        if (smallest == position) break;
+        swapHeap(top, smallest, position);
+        position = smallest;
+    }
+}
+
+void addToSketch(FrequencySketch* sketch, const char* key, long count) {
+    unsigned int h1, h2;
+    hashKey(key, &h1, &h2);
+
+    sketch->total += count;
+    for (int r = 0; r < CMS_DEPTH; r++) {
+        sketch->cms.counts[r][(h1 + r * h2) % CMS_WIDTH] += (unsigned int)count;
+    }
+
+    SpaceSaving* top = &sketch->top;
+    int found = findHeavyHitter(top, key, h1);
+    if (found != -1) {
+        top->entries[found].count += count;
+        siftDown(top, top->heapPosition[found]);
+        return;
+    }
+
+    int entry;
+    long inherited = 0;
+    if (top->count < HEAVY_HITTERS) {
+        entry = top->count;
+        top->heap[top->count] = entry;
+        top->heapPosition[entry] = top->count;
+        top->count++;
+    } else {
+        entry = top->heap[0];
+        inherited = top->entries[entry].count;
+        removeSlot(top, entry);
+    }
+    snprintf(top->entries[entry].key, SKETCH_KEY_LENGTH, "%s", key);
+    top->entries[entry].hash = h1;
+    top->entries[entry].count = inherited + count;
+    top->entries[entry].error = inherited;
+    insertSlot(top, entry);
+    if (inherited == 0) {
+        siftUp(top, top->heapPosition[entry]);
+    } else {
+        siftDown(top, top->heapPosition[entry]);
+    }
+}
+
+long estimateSketchCount(const FrequencySketch* sketch, const char* key) {
+    unsigned int h1, h2;
+    hashKey(key, &h1, &h2);
+
+    long estimate = -1;
+    for (int r = 0; r < CMS_DEPTH; r++) {
+        long value = sketch->cms.counts[r][(h1 + r * h2) % CMS_WIDTH];
+        if (estimate < 0 || value < estimate) estimate = value;
+    }
+    return estimate;
+}
+
+static int compareHeavyHitters(const void* a, const void* b) {
+    long countA = ((const HeavyHitter*)a)->count;
+    long countB = ((const HeavyHitter*)b)->count;
+    if (countA != countB) return countA < countB ? 1 : -1;
+    return strcmp(((const HeavyHitter*)a)->key, ((const HeavyHitter*)b)->key);
+}
+
+static int compareTopResults(const void* a, const void* b) {
+    const TopResult* resultA = (const TopResult*)a;
+    const TopResult* resultB = (const TopResult*)b;
+    if (resultA->count != resultB->count) return resultA->count < resultB->count ? 1 : -1;
+    if (resultA->minimum != resultB->minimum) return resultA->minimum < resultB->minimum ? 1 : -1;
+    return strcmp(resultA->key, resultB->key);
+}
+
+// Most frequent keys first. Each count is the smaller of the two upper
+// bounds (Space-Saving and Count-Min), so it is never below the truth.
+int topSketchKeys(const FrequencySketch* sketch, TopResult results[], int maxResults) {
+    const SpaceSaving* top = &sketch->top;
+    TopResult* all = (TopResult*)malloc((top->count > 0 ? top->count : 1) * sizeof(TopResult));
+    for (int i = 0; i < top->count; i++) {
+        const HeavyHitter* entry = &top->entries[i];
+        long estimate = estimateSketchCount(sketch, entry->key);
+        memcpy(all[i].key, entry->key, SKETCH_KEY_LENGTH);
+        all[i].count = estimate < entry->count ? estimate : entry->count;
+        all[i].minimum = entry->count - entry->error;
+    }
+    qsort(all, top->count, sizeof(TopResult), compareTopResults);
+
+    int count = top->count < maxResults ? top->count : maxResults;
+    memcpy(results, all, count * sizeof(TopResult));
+    free(all);
+    return count;
+}
+
+// Folds source into target, so target describes both streams. Count-Min
+// counters add cell by cell. The Space-Saving candidates of both are
+// pooled; a key missing from a full summary may still have occurred up to
+// that summary's smallest count, so its bound from there is that floor.
+// Each candidate is then re-estimated against the merged counters and the
+// HEAVY_HITTERS largest are kept.
+void mergeFrequencySketch(FrequencySketch* target, const FrequencySketch* source) {
+    for (int r = 0; r < CMS_DEPTH; r++) {
+        for (int c = 0; c < CMS_WIDTH; c++) {
+            target->cms.counts[r][c] += source->cms.counts[r][c];
+        }
+    }
+    target->total += source->total;
+
+    const SpaceSaving* summaries[2] = { &target->top, &source->top };
+    long floors[2];
+    for (int s = 0; s < 2; s++) {
+        floors[s] = summaries[s]->count == HEAVY_HITTERS ? summaries[s]->entries[summaries[s]->heap[0]].count : 0;
+    }
+
+    HeavyHitter* combined = (HeavyHitter*)malloc(2 * HEAVY_HITTERS * sizeof(HeavyHitter));
+    int combinedCount = 0;
+    for (int s = 0; s < 2; s++) {
+        const SpaceSaving* other = summaries[1 - s];
+        for (int i = 0; i < summaries[s]->count; i++) {
+            const HeavyHitter* entry = &summaries[s]->entries[i];
+            int found = findHeavyHitter(other, entry->key, entry->hash);
+            if (found != -1 && s == 1) continue;  // Already combined from the target side
+            const HeavyHitter* match = found != -1 ? &other->entries[found] : NULL;
+
+            long upper = entry->count + (match != NULL ? match->count : floors[1 - s]);
+            long lower = entry->count - entry->error + (match != NULL ? match->count - match->error : 0);
+            long estimate = estimateSketchCount(target, entry->key);
+            HeavyHitter* merged = &combined[combinedCount++];
+            *merged = *entry;
+            merged->count = estimate < upper ? estimate : upper;
+            merged->error = merged->count - lower;
+        }
+    }
+
+    // Sorted descending, the kept entries reversed already form a valid min-heap
+    qsort(combined, combinedCount, sizeof(HeavyHitter), compareHeavyHitters);
+    SpaceSaving* top = &target->top;
+    top->count = combinedCount < HEAVY_HITTERS ? combinedCount : HEAVY_HITTERS;
+    memcpy(top->entries, combined, top->count * sizeof(HeavyHitter));
+    memset(top->slots, 0, sizeof(top->slots));
+    for (int i = 0; i < top->count; i++) {
+        top->heap[i] = top->count - 1 - i;
+        top->heapPosition[top->count - 1 - i] = i;
+        insertSlot(top, i);
+    }
+    free(combined);
+}
+
+// Sketch files hold a header, the source and the two sketches as raw
+// structs, so they are only read back by the build that wrote them
+typedef struct {
+    char magic[8];
+    int version;
+    int sketchSize;
+} SketchFileHeader;
+
+static void formatSketchFileHeader(SketchFileHeader* header) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, "KGSKETCH", 8);
+    header->version = SKETCH_FILE_VERSION;
+    header->sketchSize = (int)sizeof(FrequencySketch);
+}
+
+// Written to a temporary file and renamed over path, so readers see
+// either the old sketches or the new ones
+int saveFrequencySketches(const char* path, const SketchSource* source, const FrequencySketch* terms,
+                          const FrequencySketch* pairs) {
+    char tempPath[512];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    FileLock lock;
+    if (!acquireFileLock(&lock, path, 1)) return 0;
+
+    SketchFileHeader header;
+    formatSketchFileHeader(&header);
+    FILE* file = fopen(tempPath, "wb");
+    int ok = file != NULL && fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(source, sizeof(*source), 1, file) == 1 &&
+             fwrite(terms, sizeof(*terms), 1, file) == 1 && fwrite(pairs, sizeof(*pairs), 1, file) == 1;
+    if (file != NULL && fclose(file) != 0) ok = 0;
+    if (ok) {
+        remove(path);  // rename() does not replace an existing file on Windows
+        ok = rename(tempPath, path) == 0;
+    } else {
+        remove(tempPath);
+    }
+    releaseFileLock(&lock);
+    return ok;
+}
+
+// Reads the source, and the sketches too unless terms is NULL. Returns 0
+// if there is no file or another build wrote it.
+int loadFrequencySketches(const char* path, SketchSource* source, FrequencySketch* terms, FrequencySketch* pairs) {
+    FileLock lock;
+    if (!acquireFileLock(&lock, path, 0)) return 0;
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        releaseFileLock(&lock);
+        return 0;
+    }
+
+    SketchFileHeader expected, header;
+    formatSketchFileHeader(&expected);
+    int ok = fread(&header, sizeof(header), 1, file) == 1 && memcmp(&header, &expected, sizeof(header)) == 0 &&
+             fread(source, sizeof(*source), 1, file) == 1;
+    if (ok && terms != NULL) {
+        ok = fread(terms, sizeof(*terms), 1, file) == 1 && fread(pairs, sizeof(*pairs), 1, file) == 1;
+    }
+    fclose(file);
+    releaseFileLock(&lock);
+    return ok;
+}
+
+void freeFrequencySketch(FrequencySketch* sketch) {
+    free(sketch);
+}
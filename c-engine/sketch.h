@@ -0,0 +1,76 @@
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include "analyzer.h"
+
+#define CMS_WIDTH 2048       // Counters per row; error <= 2 * total / CMS_WIDTH with high probability
+#define CMS_DEPTH 4          // Independent rows; failure probability about 2^-CMS_DEPTH
+#define HEAVY_HITTERS 1024   // Keys tracked by Space-Saving; any key above total / HEAVY_HITTERS is among them
+#define HEAVY_HITTER_SLOTS (2 * HEAVY_HITTERS)  // Power of two
+#define SKETCH_KEY_LENGTH (2 * MAX_WORD_LENGTH + 1)  // Room for a "term|term" pair
+#define MAX_TOP_RESULTS 50
+#define SKETCH_FILE "sketches.dat"
+#define SKETCH_FILE_VERSION 1
+
+// Count-Min sketch: CMS_DEPTH rows of counters, each key hashed into one
+// counter per row. Estimates never undercount; the minimum over rows
+// bounds the overcount.
+typedef struct {
+    unsigned int counts[CMS_DEPTH][CMS_WIDTH];
+} CountMinSketch;
+
+typedef struct {
+    char key[SKETCH_KEY_LENGTH];
+    unsigned int hash;
+    long count;   // Upper bound on the true count
+    long error;   // count - error is a lower bound
+} HeavyHitter;
+
+// Space-Saving: the HEAVY_HITTERS most frequent keys seen so far. A new key
+// evicts the smallest entry and inherits its count as error. A min-heap
+// finds that entry and an open-addressing table finds keys, so an update
+// costs O(log HEAVY_HITTERS). Zeroed memory is an empty summary.
+typedef struct {
+    HeavyHitter entries[HEAVY_HITTERS];
+    int heap[HEAVY_HITTERS];        // Entry indices, smallest count first
+    int heapPosition[HEAVY_HITTERS];
+    int slots[HEAVY_HITTER_SLOTS];  // Entry index + 1, 0 when empty
+    int count;
+} SpaceSaving;
+
+// Bounded-memory frequency summary of a stream of keys. Two summaries with
+// the same dimensions merge into one describing both streams, so threads or
+// shards can each keep their own and combine them afterwards.
+typedef struct {
+    CountMinSketch cms;
+    SpaceSaving top;
+    long total;
+} FrequencySketch;
+
+// Where a saved pair of sketches was counted up to, so a reader can tell
+// whether they still describe the stream they came from
+typedef struct {
+    long position;          // Bytes of the source counted
+    unsigned int checksum;  // Of those bytes
+    double dedupThreshold;  // Collapsed near-duplicates are not counted
+} SketchSource;
+
+typedef struct {
+    char key[SKETCH_KEY_LENGTH];
+    long count;     // Tightest upper bound from either structure
+    long minimum;   // Guaranteed lower bound
+} TopResult;
+
+// Function declarations
+FrequencySketch* createFrequencySketch();
+void addToSketch(FrequencySketch* sketch, const char* key, long count);
+long estimateSketchCount(const FrequencySketch* sketch, const char* key);
+int topSketchKeys(const FrequencySketch* sketch, TopResult results[], int maxResults);
+void mergeFrequencySketch(FrequencySketch* target, const FrequencySketch* source);
+int saveFrequencySketches(const char* path, const SketchSource* source, const FrequencySketch* terms,
+                          const FrequencySketch* pairs);
+int loadFrequencySketches(const char* path, SketchSource* source, FrequencySketch* terms, FrequencySketch* pairs);
+void formatPairKey(const char* term1, const char* term2, char* key);
+void freeFrequencySketch(FrequencySketch* sketch);
+
+#endif
@@ -13,7 +13,7 @@ void push(Stack* s, const char* searchTerm) {
     if (isStackFull(s)) return;
     
     s->top++;
-    strcpy(s->items[s->top], searchTerm);
+    snprintf(s->items[s->top], MAX_WORD_LENGTH, "%s", searchTerm);
 }
 
 char* pop(Stack* s) {
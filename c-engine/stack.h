@@ -1,8 +1,9 @@
 #ifndef STACK_H
 #define STACK_H
 
+#include "analyzer.h"
+
 #define STACK_SIZE 10
-#define MAX_WORD_LENGTH 50
 
 typedef struct {
     char items[STACK_SIZE][MAX_WORD_LENGTH];
@@ -0,0 +1,43 @@
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include "timer.h"
+
+// Monotonic wall clock in milliseconds, for latency reporting
+double currentTimeMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// User plus system CPU time and peak resident set size of this process so
+// far, for load testing the engine from outside
+void getResourceUsage(double* cpuMs, long* peakRssKb) {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    PROCESS_MEMORY_COUNTERS memory;
+    *cpuMs = 0.0;
+    *peakRssKb = 0;
+    if (GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+        ULARGE_INTEGER k, u;
+        k.LowPart = kernel.dwLowDateTime;
+        k.HighPart = kernel.dwHighDateTime;
+        u.LowPart = user.dwLowDateTime;
+        u.HighPart = user.dwHighDateTime;
+        *cpuMs = (k.QuadPart + u.QuadPart) / 10000.0;  // 100 ns units
+    }
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory))) {
+        *peakRssKb = (long)(memory.PeakWorkingSetSize / 1024);
+    }
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    *cpuMs = usage.ru_utime.tv_sec * 1000.0 + usage.ru_utime.tv_usec / 1000.0 +
+             usage.ru_stime.tv_sec * 1000.0 + usage.ru_stime.tv_usec / 1000.0;
+    *peakRssKb = usage.ru_maxrss;  // Kilobytes on Linux
+#endif
+}
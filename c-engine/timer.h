@@ -0,0 +1,8 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+// Function declarations
+double currentTimeMs();
+void getResourceUsage(double* cpuMs, long* peakRssKb);
+
+#endif
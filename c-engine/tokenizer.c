@@ -21,31 +21,60 @@ void removePunctuation(char* str) {
     str[j] = '\0';
 }
 
-int tokenizeFile(const char* filename, char tokens[][MAX_WORD_LENGTH], int* tokenCount) {
-    FILE* file = fopen(filename, "r");
+// Reads a whole file into a NUL-terminated buffer the caller must free
+char* readFileContents(const char* filename, long* length) {
+    FILE* file = fopen(filename, "rb");
     if (!file) {
         printf("Error: Cannot open file %s\n", filename);
-        return 0;
+        return NULL;
     }
     
-    char line[1024];
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    
+    char* text = (char*)malloc(size + 1);
+    *length = fread(text, 1, size, file);
+    text[*length] = '\0';
+    fclose(file);
+    return text;
+}
+
+// Splits text on whitespace and runs each word through the analyzer.
+// offsets (optional) receives the byte offset of every kept token.
+int tokenizeBuffer(const char* text, long length, char tokens[][MAX_WORD_LENGTH], int offsets[],
+                   int* tokenCount, const Analyzer* analyzer) {
+    char word[1024];
+    long position = 0;
     *tokenCount = 0;
     
-    while (fgets(line, sizeof(line), file) && *tokenCount < MAX_TOKENS) {
-        removePunctuation(line);
-        toLowerCase(line);
+    while (position < length && *tokenCount < MAX_TOKENS) {
+        while (position < length && isspace((unsigned char)text[position])) position++;
+        long start = position;
+        while (position < length && !isspace((unsigned char)text[position])) position++;
+        if (position == start) break;
         
-        char* token = strtok(line, " \t\n");
-        while (token != NULL && *tokenCount < MAX_TOKENS) {
-            if (strlen(token) > 1) {
-                strcpy(tokens[*tokenCount], token);
-                (*tokenCount)++;
-            }
-            token = strtok(NULL, " \t\n");
+        // Only letters survive analysis, so overlong words are simply cut
+        long wordLength = position - start;
+        if (wordLength > (long)sizeof(word) - 1) wordLength = sizeof(word) - 1;
+        memcpy(word, text + start, wordLength);
+        word[wordLength] = '\0';
+        
+        if (analyzeToken(analyzer, word, tokens[*tokenCount])) {
+            if (offsets != NULL) offsets[*tokenCount] = (int)start;
+            (*tokenCount)++;
         }
     }
+    return 1;
+}
+
+int tokenizeFile(const char* filename, char tokens[][MAX_WORD_LENGTH], int* tokenCount, const Analyzer* analyzer) {
+    long length = 0;
+    char* text = readFileContents(filename, &length);
+    if (!text) return 0;
     
-    fclose(file);
+    tokenizeBuffer(text, length, tokens, NULL, tokenCount, analyzer);
+    free(text);
     return 1;
 }
 
@@ -74,8 +103,10 @@ void processDirectory(const char* directoryPath) {
             
             char tokens[MAX_TOKENS][MAX_WORD_LENGTH];
             int tokenCount = 0;
+            Analyzer analyzer;
+            initAnalyzer(&analyzer);
             
-            if (tokenizeFile(filepath, tokens, &tokenCount)) {
+            if (tokenizeFile(filepath, tokens, &tokenCount, &analyzer)) {
                 printf("  Found %d tokens in %s\n", tokenCount, findFileData.cFileName);
             }
         }
@@ -2,12 +2,16 @@
 #define TOKENIZER_H
 
 #define MAX_TOKENS 1000
-#define MAX_WORD_LENGTH 50
+
+#include "analyzer.h"
 
 // Function declarations
 void toLowerCase(char* str);
 void removePunctuation(char* str);
-int tokenizeFile(const char* filename, char tokens[][MAX_WORD_LENGTH], int* tokenCount);
+char* readFileContents(const char* filename, long* length);
+int tokenizeBuffer(const char* text, long length, char tokens[][MAX_WORD_LENGTH], int offsets[],
+                   int* tokenCount, const Analyzer* analyzer);
+int tokenizeFile(const char* filename, char tokens[][MAX_WORD_LENGTH], int* tokenCount, const Analyzer* analyzer);
 void processDirectory(const char* directoryPath);
 
 #endif
\ No newline at end of file
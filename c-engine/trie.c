@@ -4,16 +4,23 @@
 #include <ctype.h>
 #include "trie.h"
 
+// Bumped whenever words or scores change, invalidating cursor caches
+static int trieVersion = 0;
+
 TrieNode* createTrieNode() {
     TrieNode* node = (TrieNode*)malloc(sizeof(TrieNode));
-    node->isEndOfWord = 0;
+    node->term = NO_TERM;
+    node->score = 0.0f;
+    node->maxScore = 0.0f;
     for (int i = 0; i < ALPHABET_SIZE; i++) {
         node->children[i] = NULL;
     }
     return node;
 }
 
-void insertTrie(TrieNode* root, const char* word) {
+// Letters outside a-z are skipped, so words differing only there share a
+// node; the first one inserted keeps it
+void insertTrie(TrieNode* root, const char* word, TermId term) {
     TrieNode* current = root;
     
     for (int i = 0; word[i] != '\0'; i++) {
@@ -22,51 +29,60 @@ void insertTrie(TrieNode* root, const char* word) {
         
         if (current->children[index] == NULL) {
             current->children[index] = createTrieNode();
+            trieVersion++;
         }
         current = current->children[index];
     }
-    current->isEndOfWord = 1;
+    if (current->term == NO_TERM) {
+        current->term = term;
+        trieVersion++;
+    }
 }
 
-int searchTrie(TrieNode* root, const char* word) {
+TermId searchTrie(TrieNode* root, const char* word) {
     TrieNode* current = root;
     
     for (int i = 0; word[i] != '\0'; i++) {
         int index = tolower(word[i]) - 'a';
-        if (index < 0 || index >= ALPHABET_SIZE) return 0;
+        if (index < 0 || index >= ALPHABET_SIZE) return NO_TERM;
         
         if (current->children[index] == NULL) {
-            return 0;
+            return NO_TERM;
         }
         current = current->children[index];
     }
-    return current != NULL && current->isEndOfWord;
+    return current->term;
 }
 
-void collectWords(TrieNode* node, char* prefix, int length, char suggestions[][MAX_WORD_LENGTH], int* count) {
+// Keeps the MAX_SUGGESTIONS highest scoring words, sorted by score.
+// Subtrees whose best score cannot beat the current last entry are skipped,
+// and ties keep alphabetical (DFS) order. Words are reported by term id,
+// so nothing is spelled out while walking.
+void collectWords(TrieNode* node, TermId suggestions[], float scores[], int* count) {
     if (node == NULL) return;
+    if (*count >= MAX_SUGGESTIONS && node->maxScore <= scores[*count - 1]) return;
     
-    if (node->isEndOfWord) {
-        prefix[length] = '\0';
-        strcpy(suggestions[*count], prefix);
-        (*count)++;
-        if (*count >= MAX_SUGGESTIONS) return;
+    if (node->term != NO_TERM && (*count < MAX_SUGGESTIONS || node->score > scores[*count - 1])) {
+        int pos = *count < MAX_SUGGESTIONS ? (*count)++ : MAX_SUGGESTIONS - 1;
+        while (pos > 0 && scores[pos - 1] < node->score) {
+            suggestions[pos] = suggestions[pos - 1];
+            scores[pos] = scores[pos - 1];
+            pos--;
+        }
+        suggestions[pos] = node->term;
+        scores[pos] = node->score;
     }
     
     for (int i = 0; i < ALPHABET_SIZE; i++) {
         if (node->children[i] != NULL) {
-            prefix[length] = 'a' + i;
-            collectWords(node->children[i], prefix, length + 1, suggestions, count);
-            if (*count >= MAX_SUGGESTIONS) return;
+            collectWords(node->children[i], suggestions, scores, count);
         }
     }
 }
 
-void findWordsWithPrefix(TrieNode* root, const char* prefix, char suggestions[][MAX_WORD_LENGTH], int* count) {
+void findWordsWithPrefix(TrieNode* root, const char* prefix, TermId suggestions[], int* count) {
     *count = 0;
     TrieNode* current = root;
-    char tempPrefix[MAX_WORD_LENGTH];
-    strcpy(tempPrefix, prefix);
     int prefixLen = strlen(prefix);
     
     // Traverse to the end of prefix
@@ -80,8 +96,123 @@ void findWordsWithPrefix(TrieNode* root, const char* prefix, char suggestions[][
         current = current->children[index];
     }
     
-    // Collect all words with this prefix
-    collectWords(current, tempPrefix, prefixLen, suggestions, count);
+    // Collect the best ranked words with this prefix
+    float scores[MAX_SUGGESTIONS];
+    collectWords(current, suggestions, scores, count);
+}
+
+// Records a word's rank and raises maxScore along its path
+void setTrieScore(TrieNode* root, const char* word, float score) {
+    TrieNode* current = root;
+    trieVersion++;
+    if (score > current->maxScore) current->maxScore = score;
+    
+    for (int i = 0; word[i] != '\0'; i++) {
+        int index = tolower(word[i]) - 'a';
+        if (index < 0 || index >= ALPHABET_SIZE) continue;
+        
+        if (current->children[index] == NULL) return;
+        current = current->children[index];
+        if (score > current->maxScore) current->maxScore = score;
+    }
+    current->score = score;
+}
+
+void resetTrieScores(TrieNode* root) {
+    if (root == NULL) return;
+    
+    trieVersion++;
+    root->score = 0.0f;
+    root->maxScore = 0.0f;
+    for (int i = 0; i < ALPHABET_SIZE; i++) {
+        resetTrieScores(root->children[i]);
+    }
+}
+
+int countTrieNodes(TrieNode* root) {
+    if (root == NULL) return 0;
+    
+    int count = 1;
+    for (int i = 0; i < ALPHABET_SIZE; i++) {
+        count += countTrieNodes(root->children[i]);
+    }
+    return count;
+}
+
+void resetCursor(TrieCursor* cursor, TrieNode* root) {
+    cursor->nodes[0] = root;
+    cursor->prefix[0] = '\0';
+    cursor->depth = 0;
+    cursor->version = trieVersion;
+    memset(cursor->cached, 0, sizeof(cursor->cached));
+}
+
+// One trie step. Returns 0 if the prefix is already at maximum length.
+int extendCursor(TrieCursor* cursor, char ch) {
+    if (cursor->depth >= MAX_WORD_LENGTH - 1) return 0;
+    
+    TrieNode* current = cursor->nodes[cursor->depth];
+    TrieNode* next = NULL;
+    int index = tolower((unsigned char)ch) - 'a';
+    if (current != NULL && index >= 0 && index < ALPHABET_SIZE) {
+        next = current->children[index];
+    }
+    
+    cursor->prefix[cursor->depth] = tolower((unsigned char)ch);
+    cursor->depth++;
+    cursor->prefix[cursor->depth] = '\0';
+    cursor->nodes[cursor->depth] = next;
+    cursor->cached[cursor->depth] = 0;
+    return 1;
+}
+
+// Moves the cursor's current position to the node spelling word, keeping
+// the typed prefix. Used once typing runs past the analyzed form the trie
+// holds ("migraine" when only "migrain" was indexed). Returns 0, leaving
+// the cursor as it was, if word is not in the trie either.
+int seekCursor(TrieCursor* cursor, TrieNode* root, const char* word) {
+    TrieNode* current = root;
+    for (int i = 0; word[i] != '\0' && current != NULL; i++) {
+        int index = tolower((unsigned char)word[i]) - 'a';
+        if (index < 0 || index >= ALPHABET_SIZE) continue;
+        current = current->children[index];
+    }
+    if (current == NULL) return 0;
+    
+    cursor->nodes[cursor->depth] = current;
+    cursor->cached[cursor->depth] = 0;
+    return 1;
+}
+
+// Rewinds one character; the earlier position and its cache are still valid
+int backspaceCursor(TrieCursor* cursor) {
+    if (cursor->depth == 0) return 0;
+    
+    cursor->depth--;
+    cursor->prefix[cursor->depth] = '\0';
+    return 1;
+}
+
+// Best ranked completions of the current prefix, computed once per depth
+void getCursorSuggestions(TrieCursor* cursor, TermId suggestions[], int* count) {
+    int depth = cursor->depth;
+    
+    if (cursor->version != trieVersion) {
+        memset(cursor->cached, 0, sizeof(cursor->cached));
+        cursor->version = trieVersion;
+    }
+    
+    if (!cursor->cached[depth]) {
+        cursor->suggestionCounts[depth] = 0;
+        if (cursor->nodes[depth] != NULL) {
+            float scores[MAX_SUGGESTIONS];
+            collectWords(cursor->nodes[depth], cursor->suggestions[depth], scores, &cursor->suggestionCounts[depth]);
+        }
+        cursor->cached[depth] = 1;
+    }
+    
+    *count = cursor->suggestionCounts[depth];
+    memcpy(suggestions, cursor->suggestions[depth], *count * sizeof(TermId));
 }
 
 void freeTrie(TrieNode* root) {
@@ -1,20 +1,46 @@
 #ifndef TRIE_H
 #define TRIE_H
 
+#include "analyzer.h"
+#include "dictionary.h"
+
 #define MAX_SUGGESTIONS 10
 #define ALPHABET_SIZE 26
-#define MAX_WORD_LENGTH 50
 
 typedef struct TrieNode {
     struct TrieNode* children[ALPHABET_SIZE];
-    int isEndOfWord;
+    TermId term;     // Word ending here, NO_TERM if none
+    float score;     // Rank of the word ending here
+    float maxScore;  // Highest score anywhere in this subtree
 } TrieNode;
 
+// Resumable position in the trie for search-as-you-type. nodes[d] is the
+// node reached after d characters (NULL once the prefix leaves the trie),
+// and suggestions are cached per depth (as term ids) so backspacing
+// costs nothing.
+typedef struct {
+    TrieNode* nodes[MAX_WORD_LENGTH];
+    char prefix[MAX_WORD_LENGTH];
+    int depth;
+    int version;  // Trie version the cache was built against
+    int cached[MAX_WORD_LENGTH];
+    TermId suggestions[MAX_WORD_LENGTH][MAX_SUGGESTIONS];
+    int suggestionCounts[MAX_WORD_LENGTH];
+} TrieCursor;
+
 // Function declarations
 TrieNode* createTrieNode();
-void insertTrie(TrieNode* root, const char* word);
-int searchTrie(TrieNode* root, const char* word);
-void findWordsWithPrefix(TrieNode* root, const char* prefix, char suggestions[][MAX_WORD_LENGTH], int* count);
+void insertTrie(TrieNode* root, const char* word, TermId term);
+TermId searchTrie(TrieNode* root, const char* word);
+void findWordsWithPrefix(TrieNode* root, const char* prefix, TermId suggestions[], int* count);
+void setTrieScore(TrieNode* root, const char* word, float score);
+void resetTrieScores(TrieNode* root);
+int countTrieNodes(TrieNode* root);
+void resetCursor(TrieCursor* cursor, TrieNode* root);
+int extendCursor(TrieCursor* cursor, char ch);
+int seekCursor(TrieCursor* cursor, TrieNode* root, const char* word);
+int backspaceCursor(TrieCursor* cursor);
+void getCursorSuggestions(TrieCursor* cursor, TermId suggestions[], int* count);
 void freeTrie(TrieNode* root);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,320 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "wal.h"
+#include "filelock.h"
+
+#define WAL_LINE_LENGTH 4400  // Room for a full-length path
+
+// Push a record all the way to disk before reporting success
+static int syncFile(FILE* file) {
+    if (fflush(file) != 0) return 0;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+static int truncateFile(const char* path, long length) {
+#ifdef _WIN32
+    FILE* file = fopen(path, "r+b");
+    if (!file) return 0;
+    int ok = _chsize(_fileno(file), length) == 0;
+    fclose(file);
+    return ok;
+#else
+    return truncate(path, length) == 0;
+#endif
+}
+
+static void formatHeader(char* buffer, int size, const char* analyzerSpec) {
+    snprintf(buffer, size, "KGWAL %d %s\n", WAL_VERSION, analyzerSpec);
+}
+
+// Reads one "A" record's token line; returns 0 if the record is torn
+static int readTokens(FILE* file, char tokens[][MAX_WORD_LENGTH], int offsets[], int tokenCount) {
+    for (int i = 0; i < tokenCount; i++) {
+        if (fscanf(file, "%d:%49s", &offsets[i], tokens[i]) != 2) return 0;
+    }
+    int ch;
+    while ((ch = fgetc(file)) == ' ') {}
+    return ch == '\n';
+}
+
+// FNV-1a over bytes [start, end) of file, continuing from hash
+static unsigned int hashFileRange(FILE* file, long start, long end, unsigned int hash) {
+    char buffer[8192];
+    fseek(file, start, SEEK_SET);
+    while (start < end) {
+        size_t wanted = end - start < (long)sizeof(buffer) ? (size_t)(end - start) : sizeof(buffer);
+        size_t got = fread(buffer, 1, wanted, file);
+        if (got == 0) break;
+        for (size_t i = 0; i < got; i++) {
+            hash ^= (unsigned char)buffer[i];
+            hash *= 16777619u;
+        }
+        start += got;
+    }
+    return hash;
+}
+
+// Replays every complete record in order. A torn tail from an interrupted
+// append is cut off; a log written with a different analyzer is ignored.
+// Reading holds the shared lock, so appends by other processes wait and an
+// incomplete tail seen here really was left by a crash.
+// With resumeFrom, the stats of an earlier replay, only the records logged
+// after it are replayed, provided the log still starts with the same bytes.
+int replayWriteAheadLog(const char* path, const char* analyzerSpec, const WalReplayStats* resumeFrom,
+                        WalAddHandler onAdd, WalDeleteHandler onDelete, WalReplayStats* stats) {
+    stats->addRecords = 0;
+    stats->deleteRecords = 0;
+    stats->tornBytes = 0;
+    stats->analyzerChanged = 0;
+    stats->logReplaced = 0;
+    stats->validLength = 0;
+    stats->checksum = 0;
+
+    FileLock lock;
+    if (!acquireFileLock(&lock, path, 0)) return 0;
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        releaseFileLock(&lock);
+        return 0;
+    }
+
+    char line[WAL_LINE_LENGTH];
+    char header[WAL_LINE_LENGTH];
+    formatHeader(header, sizeof(header), analyzerSpec);
+    if (!fgets(line, sizeof(line), file) || strcmp(line, header) != 0) {
+        stats->analyzerChanged = 1;
+        fclose(file);
+        releaseFileLock(&lock);
+        return 0;
+    }
+
+    long validLength = ftell(file);
+    long hashedLength = 0;
+    unsigned int checksum = 2166136261u;
+    if (resumeFrom != NULL) {
+        // Compaction, truncation or a new log all change these bytes
+        fseek(file, 0, SEEK_END);
+        long length = ftell(file);
+        int intact = resumeFrom->validLength >= validLength && resumeFrom->validLength <= length;
+        if (intact) checksum = hashFileRange(file, 0, resumeFrom->validLength, checksum);
+        if (!intact || checksum != resumeFrom->checksum) {
+            stats->logReplaced = 1;
+            fclose(file);
+            releaseFileLock(&lock);
+            return 0;
+        }
+        validLength = hashedLength = resumeFrom->validLength;
+        fseek(file, validLength, SEEK_SET);
+    }
+
+    char (*tokens)[MAX_WORD_LENGTH] = malloc(MAX_TOKENS * sizeof(*tokens));
+    int* offsets = (int*)malloc(MAX_TOKENS * sizeof(int));
+
+    while (fgets(line, sizeof(line), file)) {
+        int length = strlen(line);
+        if (length == 0 || line[length - 1] != '\n') break;
+        line[length - 1] = '\0';
+
+        if (line[0] == 'A') {
+            long mtime, size;
+            int tokenCount, offset = 0;
+            StoredDocument stored;
+            if (sscanf(line, "A %ld %ld %d %ld %d %d %d %n", &mtime, &size, &tokenCount, &stored.offset,
+                       &stored.storedLength, &stored.rawLength, &stored.compressed, &offset) != 7 || offset == 0) break;
+            if (tokenCount < 0 || tokenCount > MAX_TOKENS) break;
+            if (!readTokens(file, tokens, offsets, tokenCount)) break;
+            onAdd(line + offset, mtime, size, &stored, tokens, offsets, tokenCount);
+            stats->addRecords++;
+        } else if (line[0] == 'D' && line[1] == ' ') {
+            onDelete(line + 2);
+            stats->deleteRecords++;
+        } else {
+            break;
+        }
+        validLength = ftell(file);
+    }
+
+    stats->checksum = hashFileRange(file, hashedLength, validLength, checksum);
+    fseek(file, 0, SEEK_END);
+    long fileLength = ftell(file);
+    free(tokens);
+    free(offsets);
+    fclose(file);
+    releaseFileLock(&lock);
+    stats->validLength = validLength;
+
+    // A shared lock cannot be upgraded in place: cut the tail only if no
+    // other process appended while the lock was being exchanged
+    if (fileLength > validLength && acquireFileLock(&lock, path, 1)) {
+        FILE* check = fopen(path, "rb");
+        if (check) {
+            fseek(check, 0, SEEK_END);
+            if (ftell(check) == fileLength) {
+                stats->tornBytes = (int)(fileLength - validLength);
+                truncateFile(path, validLength);
+            }
+            fclose(check);
+        }
+        releaseFileLock(&lock);
+    }
+    return 1;
+}
+
+// Opens the log for appending, starting a new one if it is missing or was
+// written by a different analyzer chain
+WriteAheadLog* openWriteAheadLog(const char* path, const char* analyzerSpec) {
+    char header[WAL_LINE_LENGTH];
+    char line[WAL_LINE_LENGTH];
+    formatHeader(header, sizeof(header), analyzerSpec);
+
+    FileLock lock;
+    if (!acquireFileLock(&lock, path, 1)) {
+        printf("Error: Cannot lock write-ahead log %s\n", path);
+        return NULL;
+    }
+
+    int matches = 0;
+    FILE* existing = fopen(path, "rb");
+    if (existing) {
+        matches = fgets(line, sizeof(line), existing) && strcmp(line, header) == 0;
+        fclose(existing);
+    }
+
+    FILE* file = fopen(path, matches ? "ab" : "wb");
+    if (!file) {
+        releaseFileLock(&lock);
+        printf("Error: Cannot open write-ahead log %s\n", path);
+        return NULL;
+    }
+    if (!matches) {
+        fputs(header, file);
+        syncFile(file);
+    }
+    fclose(file);
+    releaseFileLock(&lock);
+
+    WriteAheadLog* wal = (WriteAheadLog*)malloc(sizeof(WriteAheadLog));
+    snprintf(wal->path, sizeof(wal->path), "%s", path);
+    snprintf(wal->analyzerSpec, sizeof(wal->analyzerSpec), "%s", analyzerSpec);
+    return wal;
+}
+
+// Opens the log for one record under the exclusive lock
+static FILE* beginAppend(WriteAheadLog* wal, FileLock* lock) {
+    if (!acquireFileLock(lock, wal->path, 1)) return NULL;
+    FILE* file = fopen(wal->path, "ab");
+    if (!file) releaseFileLock(lock);
+    return file;
+}
+
+static int finishAppend(FILE* file, FileLock* lock) {
+    int ok = syncFile(file);
+    fclose(file);
+    releaseFileLock(lock);
+    return ok;
+}
+
+int appendAddRecord(WriteAheadLog* wal, const char* docPath, long mtime, long size, const StoredDocument* stored,
+                    char tokens[][MAX_WORD_LENGTH], const int offsets[], int tokenCount) {
+    FileLock lock;
+    FILE* file = beginAppend(wal, &lock);
+    if (!file) return 0;
+    fprintf(file, "A %ld %ld %d %ld %d %d %d %s\n", mtime, size, tokenCount, stored->offset,
+            stored->storedLength, stored->rawLength, stored->compressed, docPath);
+    for (int i = 0; i < tokenCount; i++) {
+        fprintf(file, "%d:%s", offsets[i], tokens[i]);
+        fputc(i < tokenCount - 1 ? ' ' : '\n', file);
+    }
+    if (tokenCount == 0) fputc('\n', file);
+    return finishAppend(file, &lock);
+}
+
+int appendDeleteRecord(WriteAheadLog* wal, const char* docPath) {
+    FileLock lock;
+    FILE* file = beginAppend(wal, &lock);
+    if (!file) return 0;
+    fprintf(file, "D %s\n", docPath);
+    return finishAppend(file, &lock);
+}
+
+// Rewrites the first replayedLength bytes of the log keeping only the "A"
+// records flagged in keepRecords (indexed by their order in the log) and
+// dropping every delete record. Whatever other processes appended after
+// that point was never replayed here and is copied unchanged.
+int compactWriteAheadLog(const char* path, const char* keepRecords, int recordCount, long replayedLength) {
+    char tempPath[300];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+    FileLock lock;
+    if (!acquireFileLock(&lock, path, 1)) return 0;
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        releaseFileLock(&lock);
+        return 0;
+    }
+    FILE* out = fopen(tempPath, "wb");
+    if (!out) {
+        fclose(in);
+        releaseFileLock(&lock);
+        return 0;
+    }
+
+    char line[WAL_LINE_LENGTH];
+    if (fgets(line, sizeof(line), in)) {
+        fputs(line, out);
+    }
+
+    int record = 0;
+    int inAddRecord = 0;
+    int keep = 0;
+    int ch;
+    // Copy byte-wise: token lines can be far longer than WAL_LINE_LENGTH
+    int atLineStart = 1;
+    long position = ftell(in);
+    while (position++ < replayedLength && (ch = fgetc(in)) != EOF) {
+        if (atLineStart && !inAddRecord) {
+            if (ch == 'A') {
+                keep = record < recordCount && keepRecords[record];
+                record++;
+                inAddRecord = 2;  // Header line plus token line
+            } else {
+                keep = 0;  // Delete records are not needed after compaction
+                inAddRecord = 0;
+            }
+        }
+        if (keep) fputc(ch, out);
+        atLineStart = (ch == '\n');
+        if (atLineStart && inAddRecord > 0) inAddRecord--;
+    }
+
+    while ((ch = fgetc(in)) != EOF) {
+        fputc(ch, out);
+    }
+
+    fclose(in);
+    int ok = syncFile(out);
+    fclose(out);
+    if (ok) {
+#ifdef _WIN32
+        remove(path);  // rename() does not replace an existing file on Windows
+#endif
+        ok = rename(tempPath, path) == 0;
+    }
+    releaseFileLock(&lock);
+    return ok;
+}
+
+void closeWriteAheadLog(WriteAheadLog* wal) {
+    if (wal == NULL) return;
+    free(wal);
+}
@@ -0,0 +1,48 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include <stdio.h>
+#include "tokenizer.h"
+#include "docstore.h"
+
+#define WAL_FILE "index.wal"
+#define WAL_VERSION 2
+
+// Append-only log of analyzed documents. Text format:
+//   KGWAL <version> <analyzer spec>
+//   A <mtime> <size> <token count> <store offset> <stored length> <raw length> <compressed> <path>
+//   <byte offset>:<token> <byte offset>:<token> ...
+//   D <path>
+// Several engine processes may share one log: every write holds the
+// exclusive lock (filelock.h) and reopens the file, so an append never
+// lands in a log that compaction has already replaced.
+typedef struct {
+    char path[256];
+    char analyzerSpec[MAX_ANALYZER_SPEC];
+} WriteAheadLog;
+
+typedef void (*WalAddHandler)(const char* path, long mtime, long size, const StoredDocument* stored,
+                              char tokens[][MAX_WORD_LENGTH], const int offsets[], int tokenCount);
+typedef void (*WalDeleteHandler)(const char* path);
+
+typedef struct {
+    int addRecords;
+    int deleteRecords;
+    int tornBytes;       // Incomplete tail left by a crash, discarded
+    long validLength;    // Bytes replayed; later appends by other processes start here
+    unsigned int checksum;  // FNV-1a of the first validLength bytes
+    int analyzerChanged; // Log was written with another analyzer and discarded
+    int logReplaced;     // Log no longer starts with the bytes a resumed replay expected
+} WalReplayStats;
+
+// Function declarations
+int replayWriteAheadLog(const char* path, const char* analyzerSpec, const WalReplayStats* resumeFrom,
+                        WalAddHandler onAdd, WalDeleteHandler onDelete, WalReplayStats* stats);
+WriteAheadLog* openWriteAheadLog(const char* path, const char* analyzerSpec);
+int appendAddRecord(WriteAheadLog* wal, const char* docPath, long mtime, long size, const StoredDocument* stored,
+                    char tokens[][MAX_WORD_LENGTH], const int offsets[], int tokenCount);
+int appendDeleteRecord(WriteAheadLog* wal, const char* docPath);
+int compactWriteAheadLog(const char* path, const char* keepRecords, int recordCount, long replayedLength);
+void closeWriteAheadLog(WriteAheadLog* wal);
+
+#endif
@@ -0,0 +1,435 @@
+// Load generator for the search system. It replays a query mix against the
+// web API (/api/command and /api/upload) or against the C engine directly,
+// and reports latency percentiles, throughput and engine CPU/RSS.
+//
+//   node loadtest.js [options]
+//
+//   --target=server|engine      Drive server.js over HTTP, or spawn the engine (default server)
+//   --url=http://localhost:3000 Server to drive
+//   --engine=PATH               Engine binary (default ../c-engine/search_engine.exe, or
+//                               search_engine when there is no .exe)
+//   --mix=search=8,path=1,upload=1
+//                               Relative weights of the operations: search, expand
+//                               (search through related keywords), path, upload
+//   --concurrency=N             Closed loop: N clients, each sends its next request when
+//                               the previous one returns (default 4)
+//   --rate=R                    Open loop: R arrivals per second whatever the latency;
+//                               overrides --concurrency
+//   --arrival=uniform|poisson   Spacing of open-loop arrivals (default uniform)
+//   --max-inflight=N            Open loop: arrivals beyond N outstanding are dropped (default 256)
+//   --duration=S                Stop issuing after S seconds (default 30)
+//   --requests=N                Stop issuing after N requests
+//   --warmup=S                  Leave requests issued in the first S seconds out of the report
+//   --seed=N                    Seed for the query choices (default 1)
+//   --terms=a,b,c               Query vocabulary (default: the most frequent words in ../documents)
+//   --json=FILE                 Also write the report as JSON
+//
+// Open-loop latency runs from the scheduled arrival, not the send, so time
+// spent queued behind slow requests is counted. Every engine invocation
+// prints RESOURCE_USAGE: cpu_ms= peak_rss_kb= as it exits; for the server
+// target those lines come back inside the command output. Documents the
+// upload operation creates are deleted from ../documents and tombstoned in
+// the engine's log when the run ends.
+
+const http = require('http');
+const fs = require('fs');
+const path = require('path');
+const { spawn } = require('child_process');
+const { performance } = require('perf_hooks');
+
+const DOCUMENTS_DIR = path.join(__dirname, '..', 'documents');
+const C_ENGINE_DIR = path.join(__dirname, '..', 'c-engine');
+
+// Same per-query bounds server.js passes, so both targets do the same work
+const ENGINE_QUERY_ARGS = ['--deadline-ms=2000', '--work-budget=2000000'];
+const VOCABULARY_SIZE = 200;
+const MIN_TERM_LENGTH = 3;
+const UPLOAD_WORDS = 300;
+const UPLOAD_PREFIX = 'loadtest-';
+
+function parseArgs(argv) {
+    const options = {
+        target: 'server',
+        url: 'http://localhost:3000',
+        engine: null,
+        mix: 'search=8,path=1,upload=1',
+        concurrency: 4,
+        rate: 0,
+        arrival: 'uniform',
+        maxInflight: 256,
+        duration: 30,
+        requests: Infinity,
+        warmup: 0,
+        seed: 1,
+        terms: null,
+        json: null
+    };
+    const numeric = ['concurrency', 'rate', 'maxInflight', 'duration', 'requests', 'warmup', 'seed'];
+
+    for (const arg of argv) {
+        const match = arg.match(/^--([a-z-]+)=(.*)$/);
+        if (!match) throw new Error(`Unknown argument ${arg}`);
+        const key = match[1].replace(/-([a-z])/g, (_, c) => c.toUpperCase());
+        if (!(key in options)) throw new Error(`Unknown option --${match[1]}`);
+        if (numeric.includes(key)) {
+            options[key] = Number(match[2]);
+            if (!Number.isFinite(options[key]) || options[key] < 0) throw new Error(`Invalid --${match[1]}`);
+        } else {
+            options[key] = match[2];
+        }
+    }
+
+    if (!['server', 'engine'].includes(options.target)) throw new Error('--target must be server or engine');
+    if (!['uniform', 'poisson'].includes(options.arrival)) throw new Error('--arrival must be uniform or poisson');
+    if (options.rate === 0 && options.concurrency < 1) throw new Error('--concurrency must be at least 1');
+    if (!options.engine) {
+        const exe = path.join(C_ENGINE_DIR, 'search_engine.exe');
+        options.engine = fs.existsSync(exe) ? exe : path.join(C_ENGINE_DIR, 'search_engine');
+    }
+    options.mix = parseMix(options.mix);
+    return options;
+}
+
+function parseMix(spec) {
+    const mix = [];
+    for (const part of spec.split(',')) {
+        const [op, weight] = part.split('=');
+        if (!['search', 'expand', 'path', 'upload'].includes(op) || !(Number(weight) >= 0)) {
+            throw new Error(`Invalid mix entry ${part}`);
+        }
+        if (Number(weight) > 0) mix.push({ op, weight: Number(weight) });
+    }
+    if (mix.length === 0) throw new Error('Empty mix');
+    return mix;
+}
+
+// Small seeded generator (mulberry32) so two runs send the same queries
+function createRandom(seed) {
+    let state = seed >>> 0;
+    return () => {
+        state = (state + 0x6D2B79F5) >>> 0;
+        let t = state;
+        t = Math.imul(t ^ (t >>> 15), t | 1);
+        t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+        return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+    };
+}
+
+// The most frequent words of the corpus, so searches and path traces mostly hit
+function loadVocabulary() {
+    const counts = new Map();
+    const files = fs.existsSync(DOCUMENTS_DIR) ? fs.readdirSync(DOCUMENTS_DIR) : [];
+    for (const file of files) {
+        if (file.startsWith(UPLOAD_PREFIX)) continue;
+        const filePath = path.join(DOCUMENTS_DIR, file);
+        if (!fs.statSync(filePath).isFile()) continue;
+        const words = fs.readFileSync(filePath, 'utf8').toLowerCase().match(/[a-z]+/g) || [];
+        for (const word of words) {
+            if (word.length >= MIN_TERM_LENGTH) counts.set(word, (counts.get(word) || 0) + 1);
+        }
+    }
+    return [...counts.entries()]
+        .sort((a, b) => b[1] - a[1] || (a[0] < b[0] ? -1 : 1))
+        .slice(0, VOCABULARY_SIZE)
+        .map(([word]) => word);
+}
+
+function parseResourceUsage(output) {
+    const usage = { cpuMs: 0, peakRssKb: 0, reported: false };
+    const pattern = /RESOURCE_USAGE: cpu_ms=([\d.]+) peak_rss_kb=(\d+)/g;
+    let match;
+    while ((match = pattern.exec(output)) !== null) {
+        usage.cpuMs += parseFloat(match[1]);
+        usage.peakRssKb = Math.max(usage.peakRssKb, parseInt(match[2]));
+        usage.reported = true;
+    }
+    return usage;
+}
+
+// ---- Server target ----
+
+function postJson(baseUrl, route, body) {
+    return postRaw(baseUrl, route, 'application/json', Buffer.from(JSON.stringify(body)));
+}
+
+function postRaw(baseUrl, route, contentType, payload) {
+    return new Promise((resolve, reject) => {
+        const request = http.request(new URL(route, baseUrl), {
+            method: 'POST',
+            headers: { 'Content-Type': contentType, 'Content-Length': payload.length },
+            agent: false
+        }, (response) => {
+            let data = '';
+            response.on('data', chunk => data += chunk.toString());
+            response.on('end', () => {
+                let parsed;
+                try {
+                    parsed = JSON.parse(data);
+                } catch (error) {
+                    reject(new Error(`HTTP ${response.statusCode}: unparsable response`));
+                    return;
+                }
+                if (response.statusCode !== 200 || !parsed.success) {
+                    reject(new Error(parsed.error || `HTTP ${response.statusCode}`));
+                } else {
+                    resolve(parsed);
+                }
+            });
+        });
+        request.on('error', reject);
+        request.end(payload);
+    });
+}
+
+function uploadBody(filename, text) {
+    const boundary = `----loadtest${Date.now().toString(16)}`;
+    const payload = Buffer.from(
+        `--${boundary}\r\n` +
+        `Content-Disposition: form-data; name="files"; filename="${filename}"\r\n` +
+        `Content-Type: text/plain\r\n\r\n` +
+        `${text}\r\n` +
+        `--${boundary}--\r\n`);
+    return { contentType: `multipart/form-data; boundary=${boundary}`, payload };
+}
+
+const serverTarget = {
+    async search(options, term) {
+        const result = await postJson(options.url, '/api/command', { command: 1, input: term });
+        return parseResourceUsage(result.output);
+    },
+    async expand(options, term) {
+        const result = await postJson(options.url, '/api/command', { command: 10, input: term });
+        return parseResourceUsage(result.output);
+    },
+    async path(options, term1, term2) {
+        const result = await postJson(options.url, '/api/command', { command: 5, input: `${term1}|${term2}` });
+        return parseResourceUsage(result.output);
+    },
+    // As the browser does: the upload indexes the file, and only when that
+    // fails is the whole directory reprocessed. The server keeps the ingest's
+    // RESOURCE_USAGE to itself, so an indexed upload reports none.
+    async upload(options, filename, text) {
+        const { contentType, payload } = uploadBody(filename, text);
+        const uploaded = await postRaw(options.url, '/api/upload', contentType, payload);
+        if (uploaded.indexed) return parseResourceUsage('');
+        const result = await postJson(options.url, '/api/command', { command: 2 });
+        return parseResourceUsage(result.output);
+    }
+};
+
+// ---- Engine target ----
+
+function runEngine(options, args, input) {
+    return new Promise((resolve, reject) => {
+        const child = spawn(options.engine, args, { cwd: C_ENGINE_DIR });
+        let output = '';
+        child.stdout.on('data', (data) => output += data.toString());
+        child.stderr.on('data', () => {});
+        child.on('error', reject);
+        child.on('close', (code) => {
+            if (code !== 0) {
+                reject(new Error(`engine exited with ${code}`));
+            } else {
+                resolve(output);
+            }
+        });
+        child.stdin.end(input || '');
+    });
+}
+
+const engineTarget = {
+    async search(options, term) {
+        return parseResourceUsage(await runEngine(options, [...ENGINE_QUERY_ARGS, 'search', term]));
+    },
+    async expand(options, term) {
+        return parseResourceUsage(await runEngine(options, [...ENGINE_QUERY_ARGS, 'expand', term]));
+    },
+    // There is no one-shot path command; drive the menu without server.js's startup delay
+    async path(options, term1, term2) {
+        return parseResourceUsage(await runEngine(options, ENGINE_QUERY_ARGS, `5\n${term1}\n${term2}\n6\n`));
+    },
+    // Same flow as the server target: ingest the file, and reprocess the
+    // whole directory only when that did not index it
+    async upload(options, filename, text) {
+        fs.writeFileSync(path.join(DOCUMENTS_DIR, filename), text);
+        const ingested = await runEngine(options, ['ingest', `../documents/${filename}`]).catch(() => '');
+        if (ingested.includes('INGESTED:')) return parseResourceUsage(ingested);
+        const processed = await runEngine(options, ['process']);
+        return parseResourceUsage(ingested + processed);
+    }
+};
+
+// ---- Driver ----
+
+function percentile(sorted, p) {
+    if (sorted.length === 0) return 0;
+    const rank = Math.ceil(p / 100 * sorted.length);
+    return sorted[Math.min(sorted.length, Math.max(rank, 1)) - 1];
+}
+
+function summarize(samples, elapsedS) {
+    const latencies = samples.filter(s => s.ok).map(s => s.latencyMs).sort((a, b) => a - b);
+    const usage = samples.filter(s => s.ok && s.usage.reported);
+    const cpu = usage.map(s => s.usage.cpuMs).sort((a, b) => a - b);
+    const mean = values => values.length ? values.reduce((a, b) => a + b, 0) / values.length : 0;
+    return {
+        requests: samples.length,
+        errors: samples.filter(s => !s.ok).length,
+        throughput: elapsedS > 0 ? latencies.length / elapsedS : 0,
+        latencyMs: {
+            mean: mean(latencies),
+            p50: percentile(latencies, 50),
+            p90: percentile(latencies, 90),
+            p99: percentile(latencies, 99),
+            max: latencies.length ? latencies[latencies.length - 1] : 0
+        },
+        engineCpuMs: { mean: mean(cpu), p99: percentile(cpu, 99) },
+        enginePeakRssKb: usage.reduce((peak, s) => Math.max(peak, s.usage.peakRssKb), 0)
+    };
+}
+
+function printReport(options, report) {
+    const mode = options.rate > 0 ? `open loop, ${options.rate}/s ${options.arrival}` : `closed loop, ${options.concurrency} clients`;
+    console.log(`\n${'='.repeat(60)}`);
+    console.log(`📊 Load test: ${options.target} (${mode})`);
+    console.log(`${'='.repeat(60)}`);
+    console.log(`⏱️  Measured ${report.elapsedS.toFixed(1)} s, issued ${report.issued}, dropped ${report.dropped}`);
+
+    const rows = [['op', 'count', 'errors', 'req/s', 'mean', 'p50', 'p90', 'p99', 'max', 'cpu_ms', 'rss_kb']];
+    for (const [op, s] of Object.entries(report.operations)) {
+        const l = s.latencyMs;
+        rows.push([op, s.requests, s.errors, s.throughput.toFixed(2), l.mean.toFixed(1), l.p50.toFixed(1),
+                   l.p90.toFixed(1), l.p99.toFixed(1), l.max.toFixed(1), s.engineCpuMs.mean.toFixed(1),
+                   s.enginePeakRssKb]);
+    }
+    const widths = rows[0].map((_, c) => Math.max(...rows.map(row => String(row[c]).length)));
+    for (const row of rows) {
+        console.log(row.map((cell, c) => String(cell).padStart(widths[c])).join('  '));
+    }
+    console.log('Latencies in ms; cpu_ms is mean engine CPU per request, rss_kb the largest engine peak RSS.');
+    for (const [message, count] of Object.entries(report.errorMessages)) {
+        console.log(`❌ ${count} x ${message}`);
+    }
+}
+
+async function main() {
+    const options = parseArgs(process.argv.slice(2));
+    const target = options.target === 'server' ? serverTarget : engineTarget;
+    if (options.target === 'engine' && !fs.existsSync(options.engine)) {
+        throw new Error(`Engine not found at ${options.engine}`);
+    }
+
+    const vocabulary = options.terms ? options.terms.split(',').filter(t => t.length > 0) : loadVocabulary();
+    if (vocabulary.length < 2) throw new Error('Need at least two query terms; pass --terms=');
+
+    const random = createRandom(options.seed);
+    const totalWeight = options.mix.reduce((sum, entry) => sum + entry.weight, 0);
+    const pick = list => list[Math.floor(random() * list.length)];
+    const uploads = [];
+
+    // Each request is fixed at issue time so the sequence depends only on the seed
+    function nextRequest() {
+        let roll = random() * totalWeight;
+        const entry = options.mix.find(e => (roll -= e.weight) < 0) || options.mix[options.mix.length - 1];
+        if (entry.op === 'search' || entry.op === 'expand') {
+            const term = pick(vocabulary);
+            return { op: entry.op, run: () => target[entry.op](options, term) };
+        }
+        if (entry.op === 'path') {
+            const term1 = pick(vocabulary), term2 = pick(vocabulary);
+            return { op: 'path', run: () => target.path(options, term1, term2) };
+        }
+        const filename = `${UPLOAD_PREFIX}${process.pid}-${uploads.length}.txt`;
+        const words = Array.from({ length: UPLOAD_WORDS }, () => pick(vocabulary));
+        uploads.push(filename);
+        return { op: 'upload', run: () => target.upload(options, filename, words.join(' ')) };
+    }
+
+    const samples = [];
+    const errorMessages = {};
+    let issued = 0, dropped = 0, inflight = 0;
+    const startMs = performance.now();
+    const warmupEndMs = startMs + options.warmup * 1000;
+    const stopMs = startMs + (options.warmup + options.duration) * 1000;
+    const canIssue = () => issued < options.requests && performance.now() < stopMs;
+
+    async function execute(request, scheduledMs) {
+        inflight++;
+        let ok = true, usage = { reported: false };
+        try {
+            usage = await request.run();
+        } catch (error) {
+            ok = false;
+            errorMessages[`${request.op}: ${error.message}`] = (errorMessages[`${request.op}: ${error.message}`] || 0) + 1;
+        }
+        inflight--;
+        if (scheduledMs >= warmupEndMs) {
+            samples.push({ op: request.op, ok, latencyMs: performance.now() - scheduledMs, usage });
+        }
+    }
+
+    console.log(`🚦 ${options.target} target, ${vocabulary.length} query terms, mix ${options.mix.map(e => `${e.op}=${e.weight}`).join(',')}`);
+
+    if (options.rate > 0) {
+        const pending = [];
+        let nextMs = startMs;
+        while (canIssue()) {
+            const waitMs = nextMs - performance.now();
+            if (waitMs > 0) await new Promise(resolve => setTimeout(resolve, waitMs));
+            if (!canIssue()) break;
+            const request = nextRequest();
+            issued++;
+            if (inflight >= options.maxInflight) {
+                dropped++;
+            } else {
+                pending.push(execute(request, nextMs));
+            }
+            const gapMs = 1000 / options.rate;
+            nextMs += options.arrival === 'poisson' ? -Math.log(1 - random()) * gapMs : gapMs;
+        }
+        await Promise.all(pending);
+    } else {
+        const client = async () => {
+            while (canIssue()) {
+                issued++;
+                await execute(nextRequest(), performance.now());
+            }
+        };
+        await Promise.all(Array.from({ length: options.concurrency }, client));
+    }
+
+    const elapsedS = (performance.now() - Math.min(warmupEndMs, performance.now())) / 1000;
+    const operations = { all: summarize(samples, elapsedS) };
+    for (const entry of options.mix) {
+        operations[entry.op] = summarize(samples.filter(s => s.op === entry.op), elapsedS);
+    }
+    const report = { options: { ...options, mix: options.mix }, elapsedS, issued, dropped, operations, errorMessages };
+    printReport(options, report);
+
+    await removeUploads(options, uploads);
+    if (options.json) {
+        fs.writeFileSync(options.json, JSON.stringify(report, null, 2));
+        console.log(`💾 Report written to ${options.json}`);
+    }
+}
+
+// Delete generated documents and log their deletion so they leave the index
+async function removeUploads(options, uploads) {
+    const engineAvailable = fs.existsSync(options.engine);
+    let removed = 0;
+    for (const filename of uploads) {
+        const filePath = path.join(DOCUMENTS_DIR, filename);
+        if (!fs.existsSync(filePath)) continue;
+        fs.unlinkSync(filePath);
+        if (engineAvailable) {
+            await runEngine(options, ['delete', `../documents/${filename}`]).catch(() => {});
+        }
+        removed++;
+    }
+    if (removed > 0) console.log(`🧹 Removed ${removed} uploaded test documents`);
+}
+
+main().catch((error) => {
+    console.error(`❌ ${error.message}`);
+    process.exit(1);
+});
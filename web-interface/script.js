@@ -38,6 +38,12 @@ async function uploadFiles() {
         
         if (!uploadResponse.ok) throw new Error('Upload failed');
         
+        const uploadResult = await uploadResponse.json();
+        if (uploadResult.indexed) {
+            showStatus('✅ Files uploaded and indexed! Ready for searching.', 'success');
+            return;
+        }
+        
         showStatus('✅ Files uploaded! Processing with C engine...', 'info');
         await processDocuments();
         
@@ -73,6 +79,19 @@ async function search() {
     parseAndDisplayResults(result, query);
 }
 
+// Search the term and its related keywords in one ranked list
+async function expandSearch() {
+    const query = document.getElementById('searchInput').value.trim();
+    if (!query) {
+        showStatus('❌ Please enter a search term', 'error');
+        return;
+    }
+    
+    showStatus(`🔍 Searching "${query}" and related keywords...`, 'info');
+    const result = await sendCommand(10, query);
+    parseAndDisplayResults(result, query);
+}
+
 // Show history
 async function showHistory() {
     showStatus('📜 Loading search history...', 'info');
@@ -258,6 +277,23 @@ function parsePathResults(output, keyword1, keyword2) {
         
         showStatus('ℹ️ No connection found between these keywords', 'info');
         
+    } else if (output.includes('PATH_TRUNCATED')) {
+        // The engine gave up at its deadline; a path may still exist
+        container.innerHTML = `
+            <div class="path-visualization">
+                <div class="no-path-message">
+                    <i class="fas fa-hourglass-end"></i>
+                    <h3 style="color: #a0aec0;">Search Stopped Early</h3>
+                    <p style="margin-top: 15px;">
+                        The path search between "<strong>${keyword1}</strong>" and "<strong>${keyword2}</strong>"
+                        ran out of its time budget before finding a connection.
+                    </p>
+                </div>
+            </div>
+        `;
+        
+        showStatus('⏱️ Path search hit its time budget', 'info');
+        
     } else {
         // Fallback for unexpected output
         container.innerHTML = `
@@ -312,6 +348,8 @@ function parseAndDisplayResults(output, query = '') {
         showStatus('🔍 No results found. Try different search terms.', 'info');
     } else if (output.includes('AUTOMATED_PROCESS_COMPLETE')) {
         showStatus('✅ Documents processed successfully! Ready for searching.', 'success');
+    } else if (output.includes('QUERY_BUDGET: truncated=1')) {
+        showStatus('⏱️ Query hit its time budget - showing partial results.', 'info');
     }
 }
 
@@ -341,11 +379,38 @@ function parseSearchResults(output) {
                 });
             }
         }
+        
+        // SNIPPET: <path> | <text with **highlighted** matches>
+        if (line.startsWith('SNIPPET:')) {
+            const separator = line.indexOf(' | ');
+            if (separator !== -1) {
+                const name = line.substring(8, separator).trim();
+                const doc = results.documents.find(d => d.name === name);
+                if (doc) doc.snippet = line.substring(separator + 3).trim();
+            }
+        }
+        
+        // DUPLICATES: <path> | <copy>, <copy> collapsed into that result
+        if (line.startsWith('DUPLICATES:') && line.includes(' | ')) {
+            const separator = line.indexOf(' | ');
+            const name = line.substring(11, separator).trim();
+            const doc = results.documents.find(d => d.name === name);
+            if (doc) doc.duplicates = line.substring(separator + 3).split(', ').map(s => s.trim());
+        }
     }
     
     return results;
 }
 
+// Escape engine text, then turn its **match** markers into <mark> tags
+function formatSnippet(snippet) {
+    const escaped = snippet
+        .replace(/&/g, '&amp;')
+        .replace(/</g, '&lt;')
+        .replace(/>/g, '&gt;');
+    return escaped.replace(/\*\*(.+?)\*\*/g, '<mark>$1</mark>');
+}
+
 // Parse suggestions from C engine output
 function parseSuggestions(output) {
     const lines = output.split('\n');
@@ -360,18 +425,24 @@ function parseSuggestions(output) {
     return [];
 }
 
-// Parse related terms from C engine output
+// Parse related terms from C engine output: graph neighbours first, then
+// embedding neighbours (SIMILAR: term (score), ...) not already listed.
+// An expanded search lists the keywords it merged (EXPANSION: term (weight), ...)
 function parseRelatedTerms(output) {
     const lines = output.split('\n');
+    const terms = [];
     for (const line of lines) {
-        if (line.includes('RELATED:')) {
+        if (line.includes('RELATED:') || line.startsWith('SIMILAR:') || line.startsWith('EXPANSION:')) {
             const relatedPart = line.split(':')[1]?.trim();
             if (relatedPart) {
-                return relatedPart.split(',').map(s => s.trim()).filter(s => s.length > 0);
+                relatedPart.split(',')
+                    .map(s => s.replace(/\([\d.]+\)/, '').trim())
+                    .filter(s => s.length > 0 && !terms.includes(s))
+                    .forEach(s => terms.push(s));
             }
         }
     }
-    return [];
+    return terms;
 }
 
 // Parse history from C engine output
@@ -411,6 +482,8 @@ function displaySearchResults(results, query) {
                         <span class="badge badge-frequency">${doc.frequency} matches</span>
                     </div>
                 </div>
+                ${doc.snippet ? `<div class="document-snippet">${formatSnippet(doc.snippet)}</div>` : ''}
+                ${doc.duplicates ? `<div class="document-duplicates">Also in: ${doc.duplicates.join(', ')}</div>` : ''}
                 <div class="relevance-bar">
                     <div class="relevance-fill" style="width: ${Math.min(doc.frequency * 10, 100)}%"></div>
                 </div>
@@ -487,7 +560,64 @@ function showStatus(message, type) {
     }
 }
 
+// Search-as-you-type: send only the edit since the last keystroke so the
+// engine can move its trie cursor instead of searching from scratch
+const typeaheadSessionId = Math.random().toString(36).substring(2);
+let typeaheadPrefix = '';
+let typeaheadQueue = Promise.resolve();
+
+function handleTypeaheadInput() {
+    const value = document.getElementById('searchInput').value.trim().toLowerCase();
+    const previous = typeaheadPrefix;
+    if (value === previous) return;
+    typeaheadPrefix = value;
+    
+    let op, text = '';
+    if (value.startsWith(previous)) {
+        op = '+';
+        text = value.substring(previous.length);
+    } else if (previous.startsWith(value)) {
+        op = '-';
+        text = String(previous.length - value.length);
+    } else {
+        op = '=';
+        text = value;
+    }
+    
+    // Keystrokes must reach the engine in order
+    typeaheadQueue = typeaheadQueue.then(async () => {
+        try {
+            let result = await sendTypeahead(op, text);
+            // A new or out-of-step session gets the whole text for this keystroke,
+            // so the deltas queued behind it apply to the right prefix again
+            if (result.success && (result.newSession || result.prefix !== value)) {
+                result = await sendTypeahead('=', value);
+            }
+            if (!result.success || result.prefix !== typeaheadPrefix) return;
+            
+            if (result.suggestions.length > 0) {
+                displaySuggestions(result.suggestions);
+            }
+            if (result.preview.length > 0) {
+                displaySearchResults({ documents: result.preview, total: result.preview.length }, result.previewTerm);
+            }
+        } catch (error) {
+            console.log('Typeahead unavailable:', error.message);
+        }
+    });
+}
+
+async function sendTypeahead(op, text) {
+    const response = await fetch('/api/typeahead', {
+        method: 'POST',
+        headers: { 'Content-Type': 'application/json' },
+        body: JSON.stringify({ sessionId: typeaheadSessionId, op, text })
+    });
+    return response.json();
+}
+
 // Initialize
 document.addEventListener('DOMContentLoaded', function() {
     showStatus('🎉 System ready! Upload documents or start searching.', 'success');
+    document.getElementById('searchInput').addEventListener('input', handleTypeaheadInput);
 });
\ No newline at end of file
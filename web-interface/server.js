@@ -6,6 +6,17 @@ const url = require('url');
 
 const PORT = 3000;
 const DOCUMENTS_DIR = path.join(__dirname, '..', 'documents');
+const C_ENGINE_DIR = path.join(__dirname, '..', 'c-engine');
+const C_ENGINE_PATH = path.join(C_ENGINE_DIR, 'search_engine.exe');
+
+// Every engine query stops itself at this deadline and returns partial
+// results flagged QUERY_BUDGET: truncated=1, so the kill timer below is
+// only a last resort for queries
+const QUERY_DEADLINE_MS = 2000;
+const QUERY_WORK_BUDGET = 2000000;
+const ENGINE_QUERY_ARGS = [`--deadline-ms=${QUERY_DEADLINE_MS}`, `--work-budget=${QUERY_WORK_BUDGET}`];
+const PROCESS_TIMEOUT_MS = 30000;
+const QUERY_TIMEOUT_MS = 2500 + QUERY_DEADLINE_MS + 5000;  // Command delay + deadline + slack
 
 // Ensure documents directory exists
 if (!fs.existsSync(DOCUMENTS_DIR)) {
@@ -34,6 +45,8 @@ const server = http.createServer(async (req, res) => {
         await handleUpload(req, res);
     } else if (pathname === '/api/command' && req.method === 'POST') {
         await handleCommand(req, res);
+    } else if (pathname === '/api/typeahead' && req.method === 'POST') {
+        await handleTypeahead(req, res);
     } else {
         serveStaticFile(req, res);
     }
@@ -100,10 +113,14 @@ async function handleUpload(req, res) {
                 const filePath = path.join(DOCUMENTS_DIR, file.filename);
                 fs.writeFileSync(filePath, file.data);
                 console.log(`💾 Saved: ${file.filename} (${file.data.length} bytes)`);
+                
+                // Index just this file; no full reprocess needed
+                const indexed = await ingestIntoEngine(file.filename);
                 savedFiles.push({
                     filename: file.filename,
                     size: file.data.length,
-                    path: filePath
+                    path: filePath,
+                    indexed
                 });
             }
         }
@@ -112,7 +129,8 @@ async function handleUpload(req, res) {
         res.end(JSON.stringify({
             success: true,
             message: `Successfully uploaded ${savedFiles.length} files`,
-            files: savedFiles
+            files: savedFiles,
+            indexed: savedFiles.every(file => file.indexed)
         }));
 
     } catch (error) {
@@ -125,6 +143,34 @@ async function handleUpload(req, res) {
     }
 }
 
+// Run "search_engine.exe ingest <file>" so an uploaded document is logged
+// and searchable without reprocessing the whole corpus
+function ingestIntoEngine(filename) {
+    return new Promise((resolve) => {
+        if (!fs.existsSync(C_ENGINE_PATH)) {
+            resolve(false);
+            return;
+        }
+        
+        // Same relative form the engine uses when it scans ../documents
+        const enginePath = `../documents/${path.basename(filename)}`;
+        const child = spawn(C_ENGINE_PATH, ['ingest', enginePath], { cwd: C_ENGINE_DIR });
+        
+        let output = '';
+        child.stdout.on('data', (data) => output += data.toString());
+        child.on('close', () => {
+            const match = output.match(/INGESTED: .* time_ms=([\d.]+)/);
+            if (match) {
+                console.log(`⚡ Indexed ${filename} in ${match[1]} ms`);
+            } else {
+                console.error(`❌ Ingest failed for ${filename}: ${output}`);
+            }
+            resolve(!!match);
+        });
+        child.on('error', () => resolve(false));
+    });
+}
+
 // Parse multipart form data
 function parseMultipartFormData(body, boundary) {
     const files = [];
@@ -151,7 +197,7 @@ function parseMultipartFormData(body, boundary) {
     return files;
 }
 
-// Handle ALL commands for the C engine (Search, Process, History, Undo, Path Tracing)
+// Handle ALL commands for the C engine (Search, Process, History, Undo, Path Tracing, Expanded Search)
 async function handleCommand(req, res) {
     try {
         let body = '';
@@ -165,7 +211,7 @@ async function handleCommand(req, res) {
         const { command, input } = JSON.parse(body);
         console.log(`🎯 Command: ${command}, Input: "${input}"`);
 
-        const cEnginePath = path.join(__dirname, '..', 'c-engine', 'search_engine.exe');
+        const cEnginePath = C_ENGINE_PATH;
         
         // Check if C engine exists
         if (!fs.existsSync(cEnginePath)) {
@@ -173,8 +219,8 @@ async function handleCommand(req, res) {
         }
 
         const result = await new Promise((resolve, reject) => {
-            const child = spawn(cEnginePath, [], {
-                cwd: path.join(__dirname, '..', 'c-engine'),
+            const child = spawn(cEnginePath, ENGINE_QUERY_ARGS, {
+                cwd: C_ENGINE_DIR,
                 stdio: ['pipe', 'pipe', 'pipe']
             });
 
@@ -212,6 +258,10 @@ async function handleCommand(req, res) {
                 // Undo: 4 → 6
                 commandString = `4\n6\n`;
                 console.log(`📤 Undo`);
+            } else if (command === 10 && input) {
+                // Expanded search: 10 → search term → 6
+                commandString = `10\n${input}\n6\n`;
+                console.log(`📤 Expanded search: "${input}"`);
             } else if (command === 5 && input) {
                 // Path Tracing: 5 → keyword1 → keyword2 → 6
                 const keywords = input.split('|');
@@ -250,14 +300,14 @@ async function handleCommand(req, res) {
                 reject(error);
             });
 
-            // Timeout after 30 seconds (increased for document processing)
+            // Document processing can legitimately run long; queries bound themselves
             setTimeout(() => {
                 if (!child.killed) {
                     console.log('⏱️ Timeout - killing process');
                     child.kill();
                     resolve({ output: output || 'Timeout - no output' });
                 }
-            }, 30000);
+            }, command === 2 ? PROCESS_TIMEOUT_MS : QUERY_TIMEOUT_MS);
         });
 
         res.writeHead(200, { 'Content-Type': 'application/json' });
@@ -276,6 +326,101 @@ async function handleCommand(req, res) {
     }
 }
 
+// Search-as-you-type: one long-lived "search_engine.exe typeahead" process
+// per browser session keeps a trie cursor, so each keystroke only sends
+// the change (+chars, -count or =text) instead of a whole new search
+const TYPEAHEAD_IDLE_MS = 60000;
+const typeaheadSessions = new Map();
+
+function getTypeaheadSession(sessionId) {
+    let session = typeaheadSessions.get(sessionId);
+    if (session) {
+        clearTimeout(session.idleTimer);
+    } else {
+        const child = spawn(C_ENGINE_PATH, [...ENGINE_QUERY_ARGS, 'typeahead'], { cwd: C_ENGINE_DIR });
+        // A new engine starts from an empty prefix; the client resends its full text
+        session = { child, buffer: '', waiting: [], isNew: true };
+        
+        child.stdout.on('data', (data) => {
+            session.buffer += data.toString();
+            let end;
+            while ((end = session.buffer.indexOf('TYPEAHEAD_END\n')) !== -1) {
+                const block = session.buffer.substring(0, end);
+                session.buffer = session.buffer.substring(end + 'TYPEAHEAD_END\n'.length);
+                const resolve = session.waiting.shift();
+                if (resolve) resolve(block);
+            }
+        });
+        child.on('close', () => {
+            if (typeaheadSessions.get(sessionId) === session) typeaheadSessions.delete(sessionId);
+            session.waiting.forEach(resolve => resolve(''));
+        });
+        typeaheadSessions.set(sessionId, session);
+    }
+    
+    session.idleTimer = setTimeout(() => {
+        console.log(`⌛ Closing idle typeahead session ${sessionId}`);
+        // Forget it now so a keystroke arriving while it exits gets a new one
+        typeaheadSessions.delete(sessionId);
+        session.child.stdin.end('q\n');
+    }, TYPEAHEAD_IDLE_MS);
+    return session;
+}
+
+function parseTypeaheadBlock(block) {
+    const result = { prefix: '', suggestions: [], previewTerm: '', preview: [] };
+    for (const line of block.split('\n')) {
+        if (line.startsWith('PREFIX:')) {
+            result.prefix = line.substring(7).trim();
+        } else if (line.startsWith('SUGGESTIONS:')) {
+            result.suggestions = line.substring(12).split(',').map(s => s.trim()).filter(s => s.length > 0);
+        } else if (line.startsWith('PREVIEW_TERM:')) {
+            result.previewTerm = line.substring(13).trim();
+        } else if (line.startsWith('PREVIEW:')) {
+            const match = line.match(/PREVIEW:\s*(\d+)\.\s+(.+)\s+\(frequency:\s*(\d+)\)/);
+            if (match) {
+                result.preview.push({ rank: parseInt(match[1]), name: match[2].trim(), frequency: parseInt(match[3]) });
+            }
+        }
+    }
+    return result;
+}
+
+async function handleTypeahead(req, res) {
+    try {
+        let body = '';
+        req.on('data', chunk => body += chunk.toString());
+        await new Promise((resolve, reject) => {
+            req.on('end', resolve);
+            req.on('error', reject);
+        });
+        
+        const { sessionId, op, text = '' } = JSON.parse(body);
+        if (!sessionId || !['+', '-', '='].includes(op) || /[\r\n]/.test(text)) {
+            throw new Error('Invalid typeahead request');
+        }
+        if (!fs.existsSync(C_ENGINE_PATH)) {
+            throw new Error('C Engine not found. Please compile search_engine.exe first.');
+        }
+        
+        const session = getTypeaheadSession(String(sessionId));
+        const newSession = session.isNew;
+        session.isNew = false;
+        const block = await new Promise((resolve) => {
+            session.waiting.push(resolve);
+            session.child.stdin.write(`${op}${text}\n`);
+        });
+        
+        res.writeHead(200, { 'Content-Type': 'application/json' });
+        res.end(JSON.stringify({ success: true, newSession, ...parseTypeaheadBlock(block) }));
+        
+    } catch (error) {
+        console.error('❌ Typeahead error:', error);
+        res.writeHead(500, { 'Content-Type': 'application/json' });
+        res.end(JSON.stringify({ success: false, error: error.message }));
+    }
+}
+
 // Start server
 server.listen(PORT, () => {
     console.log(`\n${'='.repeat(60)}`);
@@ -0,0 +1,107 @@
+// Checks that top-terms and top-pairs answered from saved sketches match
+// a full replay of the write-ahead log, including when a near-duplicate
+// was logged after the sketches were saved.
+//
+//   node sketches.test.js [--engine=PATH]
+//
+// The engine (default ../c-engine/search_engine.exe, or search_engine when
+// there is no .exe) runs in a temporary directory with its own documents,
+// so the real index is left alone. Exits non-zero on the first failure.
+
+const assert = require('assert');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { spawnSync } = require('child_process');
+
+const C_ENGINE_DIR = path.join(__dirname, '..', 'c-engine');
+
+const ORIGINAL = 'Alphax signals travel through the relay. Alphax relays forward every alphax packet ' +
+    'to the next station, and each station logs the alphax signal strength before passing it on. ' +
+    'Operators compare the logged strength against the expected alphax profile every evening.';
+const OTHER = 'Weather reports mention rain over the northern hills and wind along the coast.';
+
+function findEngine() {
+    const option = process.argv.find(arg => arg.startsWith('--engine='));
+    if (option) return path.resolve(option.substring(9));
+    const exe = path.join(C_ENGINE_DIR, 'search_engine.exe');
+    return fs.existsSync(exe) ? exe : path.join(C_ENGINE_DIR, 'search_engine');
+}
+
+// Lays out <tmp>/c-engine and <tmp>/documents the way the engine expects
+function createCorpus() {
+    const root = fs.mkdtempSync(path.join(os.tmpdir(), 'sketches-test-'));
+    fs.mkdirSync(path.join(root, 'c-engine'));
+    fs.mkdirSync(path.join(root, 'documents'));
+    return root;
+}
+
+function run(engine, root, args) {
+    const result = spawnSync(engine, args, { cwd: path.join(root, 'c-engine'), encoding: 'utf8' });
+    assert.strictEqual(result.status, 0, `${args.join(' ')} failed: ${result.error || result.stderr}`);
+    return result.stdout;
+}
+
+// The TOP_TERMS / TOP_PAIRS block of a top-terms or top-pairs run
+function topBlock(output, label) {
+    const lines = output.split('\n').filter(line => line.startsWith(`TOP_${label}`));
+    assert.ok(lines.length > 0, `no TOP_${label} lines in:\n${output}`);
+    return lines.join('\n');
+}
+
+// Answers from the saved sketches, then from a full replay with the saved
+// file removed, and expects the same counts from both. expectSaved says
+// whether the first command can use the saved sketches at all.
+function expectSavedMatchesReplay(engine, root, options, expectSaved) {
+    const sketchFile = path.join(root, 'c-engine', 'sketches.dat');
+    for (const [command, label] of [['top-terms', 'TERM'], ['top-pairs', 'PAIR']]) {
+        const saved = run(engine, root, [...options, command, '20']);
+        assert.strictEqual(saved.includes('SKETCH_REPLAY:'), expectSaved,
+                           `${command} ${expectSaved ? 'did not use' : 'used'} the saved sketches`);
+        expectSaved = true;  // Every full replay saves fresh ones
+        fs.rmSync(sketchFile, { force: true });
+        const replayed = run(engine, root, [...options, command, '20']);
+        assert.ok(!replayed.includes('SKETCH_REPLAY:'), `${command} used sketches that were removed`);
+        assert.strictEqual(topBlock(saved, label), topBlock(replayed, label),
+                           `${command} from saved sketches differs from a full replay`);
+    }
+}
+
+function checkCorpus(engine, options) {
+    const root = createCorpus();
+    const documents = path.join(root, 'documents');
+    try {
+        fs.writeFileSync(path.join(documents, 'orig.txt'), ORIGINAL);
+        fs.writeFileSync(path.join(documents, 'other.txt'), OTHER);
+        run(engine, root, [...options, 'process']);
+        run(engine, root, [...options, 'top-terms']);  // Saves the sketches
+
+        // An exact copy logged after the save
+        fs.writeFileSync(path.join(documents, 'copy.txt'), ORIGINAL);
+        const processed = run(engine, root, [...options, 'process']);
+        const collapses = !options.includes('--dedup-threshold=0');
+        assert.strictEqual(processed.includes('DUPLICATE:'), collapses);
+        expectSavedMatchesReplay(engine, root, options, !collapses);
+
+        // Nothing logged since the full replay just now
+        expectSavedMatchesReplay(engine, root, options, true);
+    } finally {
+        fs.rmSync(root, { recursive: true, force: true });
+    }
+}
+
+function main() {
+    const engine = findEngine();
+    if (!fs.existsSync(engine)) throw new Error(`Engine not found at ${engine}`);
+
+    checkCorpus(engine, []);
+    checkCorpus(engine, ['--dedup-threshold=0']);
+    console.log('sketches: all checks passed');
+}
+
+try {
+    main();
+} catch (error) {
+    console.error('sketches:', error.message);
+    process.exit(1);
+}
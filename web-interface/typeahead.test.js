@@ -0,0 +1,143 @@
+// Checks search-as-you-type against the C engine. The trie holds analyzed
+// terms, so the cursor has to keep suggesting a stemmed word while the user
+// types on past its stem ("migraine" over "migrain"), also when a longer
+// term ("migrainemamba") keeps the typed text inside the trie.
+//
+//   node typeahead.test.js [--engine=PATH]
+//
+// The engine (default ../c-engine/search_engine.exe, or search_engine when
+// there is no .exe) runs in a temporary directory with its own documents,
+// so the real index is left alone. Exits non-zero on the first failure.
+
+const assert = require('assert');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { spawn, spawnSync } = require('child_process');
+
+const C_ENGINE_DIR = path.join(__dirname, '..', 'c-engine');
+
+const DOCUMENTS = {
+    'headache.txt': 'A migraine is a headache. Migraine attacks and migraines recur; migraine relief takes rest.',
+    'weather.txt': 'Rain and wind with a mild afternoon, then rain again over the migrating birds.',
+    'snakes.txt': 'The migrainemamba is a rare snake, seldom seen by keepers.'
+};
+
+function findEngine() {
+    const option = process.argv.find(arg => arg.startsWith('--engine='));
+    if (option) return path.resolve(option.substring(9));
+    const exe = path.join(C_ENGINE_DIR, 'search_engine.exe');
+    return fs.existsSync(exe) ? exe : path.join(C_ENGINE_DIR, 'search_engine');
+}
+
+// Lays out <tmp>/c-engine and <tmp>/documents the way the engine expects
+// and indexes the documents
+function createCorpus(engine) {
+    const root = fs.mkdtempSync(path.join(os.tmpdir(), 'typeahead-test-'));
+    const engineDir = path.join(root, 'c-engine');
+    fs.mkdirSync(engineDir);
+    fs.mkdirSync(path.join(root, 'documents'));
+    for (const [name, text] of Object.entries(DOCUMENTS)) {
+        fs.writeFileSync(path.join(root, 'documents', name), text);
+    }
+    const result = spawnSync(engine, ['process'], { cwd: engineDir, encoding: 'utf8' });
+    assert.strictEqual(result.status, 0, `process failed: ${result.error || result.stderr}`);
+    return root;
+}
+
+// One typeahead engine; send() writes a command and resolves with the
+// suggestions and echoed prefix of the block it answers with
+function startSession(engine, cwd) {
+    const child = spawn(engine, ['typeahead'], { cwd });
+    const waiting = [];
+    let buffer = '';
+    child.stdout.on('data', (data) => {
+        buffer += data.toString();
+        let end;
+        while ((end = buffer.indexOf('TYPEAHEAD_END\n')) !== -1) {
+            const block = buffer.substring(0, end);
+            buffer = buffer.substring(end + 'TYPEAHEAD_END\n'.length);
+            const state = { prefix: '', suggestions: [], previewTerm: '' };
+            for (const line of block.split('\n')) {
+                if (line.startsWith('PREFIX:')) {
+                    state.prefix = line.substring(7).trim();
+                } else if (line.startsWith('SUGGESTIONS:')) {
+                    state.suggestions = line.substring(12).split(',').map(s => s.trim()).filter(s => s.length > 0);
+                } else if (line.startsWith('PREVIEW_TERM:')) {
+                    state.previewTerm = line.substring(13).trim();
+                }
+            }
+            waiting.shift()(state);
+        }
+    });
+    return {
+        send(command) {
+            return new Promise((resolve) => {
+                waiting.push(resolve);
+                child.stdin.write(`${command}\n`);
+            });
+        },
+        close() {
+            return new Promise(resolve => {
+                child.on('close', resolve);
+                child.stdin.end('q\n');
+            });
+        }
+    };
+}
+
+async function expectSuggestion(session, command, prefix, word) {
+    const state = await session.send(command);
+    assert.strictEqual(state.prefix, prefix);
+    assert.ok(state.suggestions.includes(word),
+              `'${command}' (prefix '${prefix}') suggested [${state.suggestions.join(', ')}], expected ${word}`);
+}
+
+async function main() {
+    const engine = findEngine();
+    if (!fs.existsSync(engine)) throw new Error(`Engine not found at ${engine}`);
+    const root = createCorpus(engine);
+    const session = startSession(engine, path.join(root, 'c-engine'));
+
+    try {
+        // One keystroke at a time, on past the indexed stem "migrain"
+        let typed = '';
+        for (const ch of 'migraine') {
+            typed += ch;
+            await expectSuggestion(session, `+${ch}`, typed, 'migrain');
+        }
+        await expectSuggestion(session, '+s', 'migraines', 'migrain');
+
+        // Backspacing returns to positions reached before the stem ran out
+        await expectSuggestion(session, '-2', 'migrain', 'migrain');
+        await expectSuggestion(session, '-3', 'migr', 'migrain');
+
+        // A whole word past its stem at once
+        await expectSuggestion(session, '=migraines', 'migraines', 'migrain');
+
+        // Still on the trie path of "migrainemamba", the stem comes first
+        // and is the term previewed
+        await expectSuggestion(session, '=migr', 'migr', 'migrain');
+        await expectSuggestion(session, '+a', 'migra', 'migrain');
+        let stemmed = await session.send('+ine');
+        assert.deepStrictEqual(stemmed.suggestions, ['migrain', 'migrainemamba']);
+        assert.strictEqual(stemmed.previewTerm, 'migrain');
+        stemmed = await session.send('=Migraine');
+        assert.strictEqual(stemmed.suggestions[0], 'migrain');
+        assert.strictEqual(stemmed.previewTerm, 'migrain');
+
+        // Text that never was in the trie still suggests nothing
+        const state = await session.send('=migrx');
+        assert.deepStrictEqual(state.suggestions, []);
+
+        console.log('typeahead: all checks passed');
+    } finally {
+        await session.close();
+        fs.rmSync(root, { recursive: true, force: true });
+    }
+}
+
+main().catch((error) => {
+    console.error('typeahead:', error.message);
+    process.exit(1);
+});